@@ -24,8 +24,6 @@ if __name__ == "__main__":
     argv = sys.argv
     tuning_idx = -1
     insert_isl_flag = True
-    assign_loop_permute = False
-    explore_loop_permute = False
     for i in range(n_arg):
         arg = argv[i]            
         if 'output-dir' in arg:
@@ -37,10 +35,6 @@ if __name__ == "__main__":
             tuning_idx = i
         if 'isl-schedule-whole-component' in arg:
             insert_isl_flag = False
-        if 'loop-permute-order' in arg:
-            assign_loop_permute = True
-        if 'explore-loop-permute' in arg:
-            explore_loop_permute = True
     if n_arg > 1:
         src_file = argv[1]
         src_file_prefix = os.path.basename(src_file).split('.')[0]
@@ -69,58 +63,39 @@ if __name__ == "__main__":
         raise RuntimeError('Output directory is not specified.')
 
     # Execute the AutoSA        
+    # When exploring the loop permutation in the tuning mode, AutoSA generates
+    # the tuning information of all loop orderings in a single run.
     #start_time = time.perf_counter()
-    complete = False
-    permute_idx = 0
-    while not complete:
-        if permute_idx > 0:
-            argv.append(f'--autosa-loop-permute-order={permute_idx}')
-        process = subprocess.run(argv)
-        if process.returncode != 0:
-            print("[AutoSA] Error: Exit abnormally!")
-            sys.exit(process.returncode)
-        else:        
-            if not os.path.exists(output_dir + '/src/completed'):
-                sys.exit(process.returncode)    
-        exec_sys_cmd(f'rm {output_dir}/src/completed')                   
-        #runtime = time.perf_counter() - start_time
-        #print(f'runtime: {runtime}')
+    process = subprocess.run(argv)
+    if process.returncode != 0:
+        print("[AutoSA] Error: Exit abnormally!")
+        sys.exit(process.returncode)
+    else:        
+        if not os.path.exists(output_dir + '/src/completed'):
+            sys.exit(process.returncode)    
+    exec_sys_cmd(f'rm {output_dir}/src/completed')                   
+    #runtime = time.perf_counter() - start_time
+    #print(f'runtime: {runtime}')
 
-        # Generate the top module
-        print("[AutoSA] Post-processing the generated code...")
-        #start_time = time.perf_counter()
-        if not os.path.exists(f'{output_dir}/src/{src_file_prefix}_top_gen.cpp'):
-            raise RuntimeError(f'{output_dir}/src/{src_file_prefix}_top_gen.cpp not exists.')
-        cmd = 'g++ -o ' + output_dir + '/src/top_gen ' + output_dir + \
-              '/src/' + src_file_prefix + '_top_gen.cpp ' + \
-              '-I./src/isl/include -L./src/isl/.libs -lisl'
-        exec_sys_cmd(cmd)
-        my_env = os.environ.copy()
-        cwd = os.getcwd()
-        if 'LD_LIBRARY_PATH' in my_env:
-            my_env['LD_LIBRARY_PATH'] += os.pathsep + cwd + '/src/isl/.libs'
-        else:
-            my_env['LD_LIBRARY_PATH'] = os.pathsep + cwd + '/src/isl/.libs'
-        cmd = output_dir + '/src/top_gen'
-        process = subprocess.run(cmd.split(), env=my_env)
-        #runtime = time.perf_counter() - start_time
-        #print(f'runtime: {runtime}')
-
-        complete = True     
-        if tuning and explore_loop_permute:   
-            for filename in os.listdir(f'{output_dir}'):
-                if filename.startswith("permute"):
-                    if filename.endswith("done"):
-                        complete = True                    
-                    else:
-                        permute_idx = int(filename.split("_")[-1])                        
-                        if assign_loop_permute:
-                            complete = True
-                        else:
-                            complete = False                        
-
-                    os.remove(f'{output_dir}/{filename}')
-                    break            
+    # Generate the top module
+    print("[AutoSA] Post-processing the generated code...")
+    #start_time = time.perf_counter()
+    if not os.path.exists(f'{output_dir}/src/{src_file_prefix}_top_gen.cpp'):
+        raise RuntimeError(f'{output_dir}/src/{src_file_prefix}_top_gen.cpp not exists.')
+    cmd = 'g++ -o ' + output_dir + '/src/top_gen ' + output_dir + \
+          '/src/' + src_file_prefix + '_top_gen.cpp ' + \
+          '-I./src/isl/include -L./src/isl/.libs -lisl'
+    exec_sys_cmd(cmd)
+    my_env = os.environ.copy()
+    cwd = os.getcwd()
+    if 'LD_LIBRARY_PATH' in my_env:
+        my_env['LD_LIBRARY_PATH'] += os.pathsep + cwd + '/src/isl/.libs'
+    else:
+        my_env['LD_LIBRARY_PATH'] = os.pathsep + cwd + '/src/isl/.libs'
+    cmd = output_dir + '/src/top_gen'
+    process = subprocess.run(cmd.split(), env=my_env)
+    #runtime = time.perf_counter() - start_time
+    #print(f'runtime: {runtime}')
 
     if not tuning:
         # Generate the final code    
@@ -434,7 +434,7 @@ def predict_module_latency_xilinx(loop_struct, config):
         latency = latency * max(block_latency, 1)
         config['latency'] = latency
 
-def predict_design_latency(latency_info, cycle=5, early_stop=-1):
+def predict_design_latency(latency_info, cycle=5, early_stop=-1, module_latency=None):
     """ Predict the latency for a single design.
 
     We assume that the II and depth for each stmt to be one.
@@ -447,6 +447,8 @@ def predict_design_latency(latency_info, cycle=5, early_stop=-1):
         The cycle time. (in ns)
     early_stop: int
         The baseline latency. If set -1, early stop is disabled.
+    module_latency: dict
+        If not None, it is filled with the predicted latency of each module.
     """
     latency_all = {}
     config = {}
@@ -555,6 +557,8 @@ def predict_design_latency(latency_info, cycle=5, early_stop=-1):
                 return config['latency']
 
     #print(latency_all)
+    if module_latency is not None:
+        module_latency.update(latency_all)
     drain_last_tile_latency = drain_latency / drain_outer
     latency = 0
     for lat in latency_all:
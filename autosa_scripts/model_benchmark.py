@@ -0,0 +1,331 @@
+#!/usr/bin/env python3
+
+import os
+import re
+import json
+import argparse
+import logging
+import xml.etree.ElementTree as ET
+from statistics import mean
+
+import resource_model as res_model
+import latency_model as lat_model
+
+RESOURCES = ['LUT', 'FF', 'BRAM18K', 'DSP', 'URAM']
+METRICS = RESOURCES + ['latency']
+
+def collect_designs(root_dir):
+    """ Collect all the synthesized designs under the directory.
+
+    A design directory contains the folders "resource_est", "latency_est", and
+    "hls_prj" generated by AutoSA and Vivado HLS, e.g., the designs under
+    "optimizer/synth" generated by the auto-tuner.
+
+    Parameters
+    ----------
+    root_dir: str
+        The directory to search for designs.
+    """
+    designs = []
+    for cur_dir, dirs, files in os.walk(root_dir):
+        if os.path.isfile(f'{cur_dir}/resource_est/design_info.json') and \
+           os.path.isdir(f'{cur_dir}/latency_est') and \
+           os.path.isdir(f'{cur_dir}/hls_prj'):
+            designs.append(cur_dir)
+            dirs[:] = []
+    designs.sort()
+    return designs
+
+def extract_design_cmd(design_dir):
+    """ Load the AutoSA command that generates the design.
+    The auto-tuner stores the command in the file "design.info" next to the
+    "output" folder of each design. Return None if not found.
+
+    Parameters
+    ----------
+    design_dir: str
+        The design directory.
+    """
+    for path in [f'{design_dir}/design.info', f'{design_dir}/../design.info']:
+        if os.path.isfile(path):
+            with open(path) as f:
+                return f.read().strip()
+    return None
+
+def extract_stage_options(cmd):
+    """ Extract the optimization stages applied to the design from the AutoSA
+    command, e.g., "array_part+latency+simd". The designs are grouped by the
+    stages when reporting the model accuracy.
+
+    Parameters
+    ----------
+    cmd: str
+        The AutoSA command.
+    """
+    if not cmd:
+        return 'unknown'
+    match = re.search(r'--sa-sizes="?\{([^}]*)\}', cmd)
+    stages = []
+    if match:
+        for size in match.group(1).split(';'):
+            stage = re.search(r'->(\w+)\[', size)
+            if stage and stage.group(1) != 'space_time':
+                stages.append(stage.group(1))
+    for opt in ['--two-level-buffer', '--local-reduce', '--host-serialize']:
+        if opt in cmd:
+            stages.append(opt[2:])
+    if not stages:
+        return 'default'
+    return '+'.join(stages)
+
+def extract_latency_from_hls_rpt(rpt):
+    """ Extract the worst-case latency (in cycles) from the HLS report in XML format.
+    Return None if the latency is undefined.
+
+    Parameters
+    ----------
+    rpt:
+        HLS report in XML format
+    """
+    item = rpt.find('PerformanceEstimates/SummaryOfOverallLatency/Worst-caseLatency')
+    if item is None or not item.text or not item.text.strip().isdigit():
+        return None
+    return int(item.text)
+
+def extract_hls_latency(design_dir):
+    """ Extract the latency of the design and each module from the HLS reports.
+    For modules with multiple instances, the maximal latency is taken.
+
+    Parameters
+    ----------
+    design_dir: str
+        The design directory.
+    """
+    hls_rpts_dir = f'{design_dir}/hls_prj/solution1/syn/report'
+    design_latency = None
+    module_latency = {}
+    for r in os.listdir(hls_rpts_dir):
+        if not r.endswith('_csynth.xml'):
+            continue
+        with open(f'{hls_rpts_dir}/{r}', 'r') as f:
+            root = ET.parse(f).getroot()
+        latency = extract_latency_from_hls_rpt(root)
+        if latency is None:
+            continue
+        module_name = r[:-11]
+        if module_name == 'kernel0':
+            design_latency = latency
+            continue
+        # For duplicate modules, get rid of the digits suffix.
+        while module_name[-1].isdigit():
+            module_name = module_name[:-1]
+        if module_name.endswith('_wrapper'):
+            module_name = module_name[:-8]
+        module_latency[module_name] = max(module_latency.get(module_name, 0), latency)
+
+    return design_latency, module_latency
+
+def evaluate_design(design_dir, model_path, cycle):
+    """ Compare the predicted resource usage and latency of the design with the
+    HLS reports.
+
+    Returns a dictionary containing the following information:
+    - kernel: str
+    - stages: str
+    - design: {metric: [HLS, predicted]}
+    - modules: {module_name: {metric: [HLS, predicted]}}
+
+    Parameters
+    ----------
+    design_dir: str
+        The design directory.
+    model_path: str
+        Directory to the resource models of all kernels.
+    cycle: int
+        The cycle time. (in ns)
+    """
+    design_info = res_model.extract_design_info(design_dir, 1)
+    modules, fifos, df = res_model.convert_design_infos_to_df([design_info])
+    kernel = f'kernel{design_info["kernel_id"]}'
+    module_resource = {}
+    res = res_model.predict_design_resource_usage(
+        df, modules, fifos, design_info, f'{model_path}/{kernel}',
+        module_resource=module_resource)
+
+    ret = {'kernel': kernel, 'stages': extract_stage_options(extract_design_cmd(design_dir)), \
+           'design': {}, 'modules': {}}
+    for r in RESOURCES:
+        ret['design'][r] = [float(design_info[r]), float(res[r])]
+    for module in design_info['modules']:
+        info = design_info['modules'][module]
+        if module not in module_resource or info['FF'] is None:
+            # The module is inlined
+            continue
+        ret['modules'][module] = {}
+        for r in RESOURCES:
+            hls = float(info[r])
+            if r == 'FF' and 'local_buffers' in info:
+                # The FF arrays are excluded from the HLS report when training the models.
+                for local_buffer in info['local_buffers']:
+                    if local_buffer['mem_type'] == 'FF':
+                        hls += res_model.FF_array_predict_HLS(local_buffer['port_width'], \
+                                                              local_buffer['buffer_depth'])
+            ret['modules'][module][r] = [hls, float(module_resource[module][r])]
+
+    hls_latency, hls_module_latency = extract_hls_latency(design_dir)
+    module_latency = {}
+    latency_info = lat_model.extract_latency_info(design_dir)
+    latency = lat_model.predict_design_latency(latency_info, cycle, module_latency=module_latency)
+    if hls_latency is not None:
+        ret['design']['latency'] = [float(hls_latency), float(latency)]
+    for module in module_latency:
+        if module in hls_module_latency:
+            if module not in ret['modules']:
+                ret['modules'][module] = {}
+            ret['modules'][module]['latency'] = [float(hls_module_latency[module]), float(module_latency[module])]
+
+    return ret
+
+def summarize(records):
+    """ Compute the mean absolute percentage error of each metric.
+
+    Parameters
+    ----------
+    records: list
+        A list of {metric: [HLS, predicted]}.
+    """
+    summary = {}
+    for metric in METRICS:
+        errors = [res_model.mean_absolute_percentage_error(rec[metric][0], rec[metric][1]) \
+                  for rec in records if metric in rec]
+        if errors:
+            summary[metric] = mean(errors)
+    summary['n'] = len(records)
+    return summary
+
+def benchmark(results):
+    """ Summarize the model accuracy at the design level, and grouped by the
+    kernels, the optimization stages, and the modules.
+
+    Parameters
+    ----------
+    results: list
+        A list of the results of "evaluate_design".
+    """
+    report = {'design': summarize([ret['design'] for ret in results]), \
+              'kernel': {}, 'stages': {}, 'module': {}}
+    for group in ['kernel', 'stages']:
+        keys = sorted(set([ret[group] for ret in results]))
+        for key in keys:
+            report[group][key] = summarize([ret['design'] for ret in results if ret[group] == key])
+    module_records = {}
+    for ret in results:
+        for module in ret['modules']:
+            key = f'{ret["kernel"]}/{module}'
+            if key not in module_records:
+                module_records[key] = []
+            module_records[key].append(ret['modules'][module])
+    for key in sorted(module_records):
+        report['module'][key] = summarize(module_records[key])
+
+    return report
+
+def print_report(report, logger):
+    """ Print the accuracy report as tables.
+
+    Parameters
+    ----------
+    report: dict
+        The report generated by "benchmark".
+    logger:
+        Logger.
+    """
+    def print_row(name, summary):
+        row = f'{name:<48}{summary["n"]:>6}'
+        for metric in METRICS:
+            if metric in summary:
+                row += f'{summary[metric]:>9.2f}%'
+            else:
+                row += f'{"-":>10}'
+        logger.info(row)
+
+    header = f'{"":<48}{"#":>6}' + ''.join([f'{metric:>10}' for metric in METRICS])
+    logger.info('======== Design-Level Model Accuracy (MAPE) ========')
+    logger.info(header)
+    print_row('all', report['design'])
+    for group in ['kernel', 'stages']:
+        logger.info(f'======== Design-Level Model Accuracy (MAPE) by {group} ========')
+        logger.info(header)
+        for key in report[group]:
+            print_row(key, report[group][key])
+    logger.info('======== Module-Level Model Accuracy (MAPE) ========')
+    logger.info(header)
+    for key in report['module']:
+        print_row(key, report['module'][key])
+
+def compare_baseline(report, baseline, tolerance, logger):
+    """ Compare the report with the baseline.
+    Return the number of the metrics whose errors increase by more than
+    "tolerance" percentage points.
+
+    Parameters
+    ----------
+    report: dict
+        The current report.
+    baseline: dict
+        The baseline report.
+    tolerance: float
+        The tolerated increase of the errors.
+    logger:
+        Logger.
+    """
+    n_drift = 0
+    entries = [('design', report['design'], baseline['design'])]
+    for group in ['kernel', 'stages', 'module']:
+        for key in report[group]:
+            if key in baseline[group]:
+                entries.append((f'{group} {key}', report[group][key], baseline[group][key]))
+    for name, cur, base in entries:
+        for metric in METRICS:
+            if metric in cur and metric in base and cur[metric] > base[metric] + tolerance:
+                logger.warning(f'{name} {metric}: {base[metric]:.2f}% -> {cur[metric]:.2f}%')
+                n_drift += 1
+    if n_drift == 0:
+        logger.info('No drift from the baseline is found.')
+    return n_drift
+
+if __name__ == "__main__":
+    parser = argparse.ArgumentParser(description="==== AutoSA Model Accuracy Benchmark ====")
+    parser.add_argument('-d', required=True, help='directory of the synthesized designs')
+    parser.add_argument('-m', required=True, help='resource model path')
+    parser.add_argument('-o', required=False, help='output report')
+    parser.add_argument('--cycle', type=int, default=5, help='cycle period (in ns)')
+    parser.add_argument('--baseline', required=False, help='baseline report to compare with')
+    parser.add_argument('--tolerance', type=float, default=5.0, \
+        help='tolerated MAPE increase from the baseline (in percentage points)')
+
+    args = parser.parse_args()
+    logging.basicConfig(format='[%(name)s %(asctime)s] %(levelname)s: %(message)s', \
+                        datefmt='%Y-%m-%d %H:%M:%S', level=logging.INFO)
+    logger = logging.getLogger('AutoSA-Benchmark')
+
+    results = []
+    for design_dir in collect_designs(args.d):
+        try:
+            results.append(evaluate_design(design_dir, args.m, args.cycle))
+        except (OSError, KeyError, ValueError) as e:
+            logger.warning(f'Skip {design_dir}: {e}')
+    if not results:
+        logger.error(f'No synthesized designs are found under {args.d}')
+        exit(1)
+    logger.info(f'{len(results)} designs are evaluated.')
+    report = benchmark(results)
+    print_report(report, logger)
+    if args.o:
+        with open(args.o, 'w') as f:
+            json.dump(report, f, indent=4)
+    if args.baseline:
+        with open(args.baseline) as f:
+            baseline = json.load(f)
+        if compare_baseline(report, baseline, args.tolerance, logger) > 0:
+            exit(1)
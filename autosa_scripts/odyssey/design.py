@@ -2,6 +2,11 @@ import numpy as np
 import json
 import sys
 import os
+import io
+import re
+import hashlib
+import math
+import utils
 from numpy import ceil, floor
 
 class Design(object):
@@ -13,8 +18,17 @@ class Design(object):
         self.infer_params_func = None
         self.random_sampling_func = None
         self.bound_check_func = None
+        self.est_resource_batch_func = None
+        self.est_latency_batch_func = None
+        self.est_activity_batch_func = None
+        self.infer_params_batch_func = None
+        self.bound_check_batch_func = None
+        self.est_resource_interval_func = None
+        self.est_latency_interval_func = None
+        self.bound_exprs = {}
         self.params_config = None      
         self.desp = None  
+        self.desp_hash = None
 
     def print_resource_est_func(self, f, desp):
         f.write("def est_resource(params):\n")
@@ -891,6 +905,104 @@ class Design(object):
         
         f.write("\treturn True\n\n")        
 
+    def print_batch_est_func(self, f, desp, print_func, suffix="batch", ops="np.ceil, utils.batch_max, utils.batch_min"):
+        """ Print the batch version of the estimation function printed by "print_func".
+        The batch function takes the parameters as a dict of arrays (one entry per 
+        sample) and evaluates the whole population with element-wise numpy operations.
+        With suffix "interval", the parameters are intervals and the function bounds 
+        the estimation with interval arithmetic.
+        """
+        buf = io.StringIO()
+        print_func(buf, desp)
+        lines = buf.getvalue().split("\n")
+        # def est_xxx(params): -> def est_xxx_batch(params):
+        lines[0] = lines[0].replace("(params):", f"_{suffix}(params):")
+        # Replace the scalar operators right after loading the parameters
+        lines.insert(2, f"\tceil, max, min = {ops}")
+        # Avoid in-place updates on arrays that alias the parameters
+        for idx in range(len(lines)):
+            m = re.match(r"^(\s+)(\S+) ([*+])= (.*)$", lines[idx])
+            if m:
+                lines[idx] = f"{m.group(1)}{m.group(2)} = {m.group(2)} {m.group(3)} ({m.group(4)})"
+        f.write("\n".join(lines))
+
+    def print_infer_params_batch_func(self, f, desp):
+        f.write("def infer_params_batch(params):\n")
+        # Load parameters
+        f.write("\t")
+        is_first = True
+        for p in desp["params"]:
+            if "tags" in p and "auto_infer" in p["tags"]:
+                continue
+            if not is_first:
+                f.write(", ")            
+            f.write(p["name"])
+            is_first = False
+        f.write(" = ")
+        is_first = True
+        for p in desp["params"]:
+            if "tags" in p and "auto_infer" in p["tags"]:
+                continue
+            if not is_first:
+                f.write(", ")            
+            f.write(f'params[\"{p["name"]}\"]')
+            is_first = False
+        f.write("\n")
+        f.write("\tceil, max, min = np.ceil, utils.batch_max, utils.batch_min\n")
+        f.write("\tvalid = np.ones(utils.batch_size(params), dtype=bool)\n\n")
+
+        for p in desp["params"]:
+            if "tags" in p and "auto_infer" in p["tags"]:
+                f.write(f"\tparams[\"{p['name']}\"], {p['name']}_valid = utils.batch_max_multiple_divisor({p['bounds'][0]}, {p['bounds'][1]})\n")
+                f.write(f"\tvalid &= {p['name']}_valid\n")
+        f.write("\n")                
+        f.write("\treturn params, valid\n\n")
+
+    def print_bound_check_batch_func(self, f, desp):
+        f.write("def bound_check_batch(params):\n")
+        # Load parameters
+        f.write("\t")
+        is_first = True
+        for p in desp["params"]:
+            if not is_first:
+                f.write(", ")
+            f.write(p["name"])
+            is_first = False
+        f.write(" = ")
+        is_first = True
+        for p in desp["params"]:
+            if not is_first:
+                f.write(", ")
+            f.write(f'params[\"{p["name"]}\"]')
+            is_first = False
+        f.write("\n")
+        f.write("\tceil, max, min = np.ceil, utils.batch_max, utils.batch_min\n")
+        f.write("\tvalid = np.ones(utils.batch_size(params), dtype=bool)\n\n")
+        for p in desp["params"]:
+            if "bounds" in p:
+                f.write(f"\tvalid &= ({p['name']} >= {p['bounds'][0]})\n")
+                # If the parameter is the first-level tiling factors, 
+                # ignore the upper bounds.
+                if not p['name'].endswith('t1'):
+                    f.write(f"\tvalid &= ({p['name']} <= {p['bounds'][1]})\n")
+            if "tags" in p and "power_of_two" in p["tags"]:
+                f.write(f"\tvalid &= ~utils.batch_non_power_of_two({p['name']})\n")
+        # Latency hiding
+        if "PE" in desp["memory"]:
+            f.write(f"\tlatency_factors = 1\n")
+            for p, param in self.params_config["tunable"].items():
+                if param["attr"] == "latency_tiling_factor":
+                    f.write(f"\tlatency_factors = latency_factors * {param['name']}\n")
+                if param["attr"] == "SIMD_tiling_factor":
+                    f.write(f"\tsimd_factor = {param['name']}\n")
+            data_type = desp["memory"]["PE"]["ele_type"]
+            if data_type == "float":
+                f.write(f"\tvalid &= (latency_factors >= 8 * simd_factor)\n")
+            else:
+                raise RuntimeError(f"Unsupported data type in random sample generation: {data_type}")
+        
+        f.write("\treturn valid\n\n")        
+
     def print_compute_arch_cst_func(self, f, desp):
         f.write("def compute_arch_cst(params):\n")
         # Load parameters
@@ -948,6 +1060,7 @@ class Design(object):
         # Print design function            
         with open(py_f, 'w') as f:
             f.write("from math import ceil\n")
+            f.write("import math\n")
             f.write("import numpy as np\n")
             f.write("import random\n")
             f.write("import utils\n\n")
@@ -973,6 +1086,18 @@ class Design(object):
             # Generate the compute arch cst func
             self.print_compute_arch_cst_func(f, desp)                
 
+            # Generate the batch functions that evaluate a population at once
+            self.print_batch_est_func(f, desp, self.print_resource_est_func)
+            self.print_batch_est_func(f, desp, self.print_latency_est_func)
+            self.print_batch_est_func(f, desp, self.print_activity_est_func)
+            self.print_infer_params_batch_func(f, desp)
+            self.print_bound_check_batch_func(f, desp)
+
+            # Generate the interval functions that bound the partially assigned designs
+            interval_ops = "math.ceil, utils.interval_max, utils.interval_min"
+            self.print_batch_est_func(f, desp, self.print_resource_est_func, "interval", interval_ops)
+            self.print_batch_est_func(f, desp, self.print_latency_est_func, "interval", interval_ops)
+
         sys.path.append(os.path.dirname(py_f))
         basename = os.path.basename(py_f).split(".")[0]        
         module = __import__(basename)
@@ -983,7 +1108,69 @@ class Design(object):
         self.random_sampling_func = module.random_sampling
         self.bound_check_func = module.bound_check
         self.compute_arch_cst_func = module.compute_arch_cst
+        self.est_resource_batch_func = module.est_resource_batch
+        self.est_latency_batch_func = module.est_latency_batch
+        self.est_activity_batch_func = module.est_activity_batch
+        self.infer_params_batch_func = module.infer_params_batch
+        self.bound_check_batch_func = module.bound_check_batch
+        self.est_resource_interval_func = module.est_resource_interval
+        self.est_latency_interval_func = module.est_latency_interval
         self.desp = desp
+        self.desp_hash = hashlib.sha1(json.dumps(desp, sort_keys=True).encode()).hexdigest()
+
+    def param_intervals(self, params):
+        """ Return the interval of each parameter given the partial assignment "params".
+        The unassigned parameters span their bounds, which are evaluated over the 
+        intervals of the parameters they depend on.
+        """
+        env = {"min": utils.interval_min, "max": utils.interval_max, "ceil": math.ceil, "floor": math.floor}
+        if not self.bound_exprs:
+            for p in self.desp["params"]:
+                if "bounds" in p:
+                    self.bound_exprs[p["name"]] = [compile(b, "<bound>", "eval") for b in p["bounds"]]
+        intervals = {}
+        for p in self.desp["params"]:
+            if p["name"] in params:
+                intervals[p["name"]] = utils.Interval(params[p["name"]])
+            elif p["name"] in self.bound_exprs:
+                lb = utils.Interval.wrap(eval(self.bound_exprs[p["name"]][0], env, intervals))
+                ub = utils.Interval.wrap(eval(self.bound_exprs[p["name"]][1], env, intervals))
+                intervals[p["name"]] = utils.Interval(max(lb.lo, 1), max(ub.hi, 1))
+            else:
+                intervals[p["name"]] = utils.Interval(1, math.inf)
+        return intervals
+
+    def est_bounds(self, params):
+        """ Return the lower bounds of the resource usage and latency of all the 
+        designs that complete the partial assignment "params".
+        """
+        intervals = self.param_intervals(params)
+        resource, _ = self.est_resource_interval_func(intervals)
+        latency, _ = self.est_latency_interval_func(intervals)
+        bounds = {res: utils.Interval.wrap(resource[res]).lo for res in ["DSP", "BRAM18K", "URAM"]}
+        bounds["latency"] = utils.Interval.wrap(latency).lo
+        return bounds
+
+    def sa_sizes(self, params):
+        """ Generate the AutoSA arguments to regenerate the design.
+        The design name "kernel<N>" corresponds to the space-time transformation "N".
+        The design name "kernel<N>_<M>" further selects the loop ordering "M" found 
+        when exploring the loop permutation, which is passed with "--loop-permute-order".
+        """
+        stages = [("array_part", "array_part_tiling_factor"), ("latency", "latency_tiling_factor"), \
+                  ("simd", "SIMD_tiling_factor")]
+        sizes = []
+        match = re.fullmatch(r"kernel(\d+)(?:_(\d+))?", self.name)
+        if match:
+            sizes.append(f"kernel[]->space_time[{match.group(1)}]")
+        for stage, attr in stages:
+            factors = [str(int(params[p["name"]])) for p in self.desp["params"] if p["attr"] == attr]
+            if factors:
+                sizes.append(f"kernel[]->{stage}[{','.join(factors)}]")
+        args = '--sa-sizes="{' + ';'.join(sizes) + '}"'
+        if match and match.group(2) is not None:
+            args += f' --explore-loop-permute --loop-permute-order={match.group(2)}'
+        return args
 
     def est_latency(self, params):
         if not self.est_latency_func:
@@ -1032,4 +1219,34 @@ class Design(object):
                 arch_cst['res_usage'] = res
                 return arch_cst
             else:
-                return None
\ No newline at end of file
+                return None
+
+    def est_latency_batch(self, params):
+        if not self.est_latency_batch_func:
+            raise RuntimeError(f"Batch latency estimation function for design {self.name} undefined")
+        else:
+            return self.est_latency_batch_func(params)
+
+    def est_resource_batch(self, params):
+        if not self.est_resource_batch_func:
+            raise RuntimeError(f"Batch resource estimation function for design {self.name} undefined")
+        else:
+            return self.est_resource_batch_func(params)
+
+    def est_activity_batch(self, params):
+        if not self.est_activity_batch_func:
+            raise RuntimeError(f"Batch activity estimation function for design {self.name} undefined")
+        else:
+            return self.est_activity_batch_func(params)
+
+    def infer_params_batch(self, params):
+        if not self.infer_params_batch_func:
+            raise RuntimeError(f"Batch internal parameter inference function for design {self.name} undefined")
+        else:
+            return self.infer_params_batch_func(params)
+
+    def bound_check_batch(self, params):
+        if not self.bound_check_batch_func:
+            raise RuntimeError(f"Batch bound check function for design {self.name} undefined")
+        else:
+            return self.bound_check_batch_func(params)
@@ -58,6 +58,41 @@ class ArchExplorer(object):
 
         return best_record
 
+    def search_pareto(self, design_idx=-1):
+        """ Search the Pareto front of each workload over the objectives in 
+        SingleTask.OBJECTIVES. The fronts of all the designs are merged.
+        Return a dict that maps the workload name to the list of Pareto-optimal designs.
+        """
+        design_list = self.designs
+        if design_idx != -1:
+            design_list = [self.designs[design_idx]]
+
+        job_list = []
+        for workload in self.workloads:
+            for design in design_list:
+                search_task = SingleTask(design, workload, self.cst)
+                job_list.append(
+                    {'job_hash': str(search_task), 'func': tuners.pareto_search, \
+                     'args': [search_task, self.cst, self.max_epochs, self.max_time, 1, \
+                              1 if self.search_config["n_worker"] > 1 else 0, \
+                              self.search_config['genetic_params']['population_size'][0]]})
+        pool = utils.MyExecutor(self.search_config['n_worker'])
+        results = pool.exec(job_list)
+
+        fronts = {}
+        for workload in self.workloads:
+            designs = []
+            for r in results:
+                designs += [d for d in results[r] if d["workload"] == workload["name"]]
+            if len(designs) == 0:
+                fronts[workload["name"]] = []
+                continue
+            objs = np.array([[d["objectives"][obj] for obj in SingleTask.OBJECTIVES] for d in designs])
+            ranks = utils.non_dominated_sort(objs)
+            fronts[workload["name"]] = [designs[i] for i in np.argsort(objs[:, 0], kind='stable') if ranks[i] == 0]
+
+        return fronts
+
     def tune(self, search_task, init_tasks=None, silent=0, use_cache=-1, meta=None):
         """ Call tuners for the searching task.
         init_tasks contains candidates for the initial population of the genetic search.
@@ -71,6 +106,14 @@ class ArchExplorer(object):
                 return self.search_config["search_records_db"][str(search_task)]
                 #return self.search_config["search_records_db"][str(search_task)], self.search_config["search_records_db"]
 
+        # Finished searching tasks are checkpointed as a whole, so that a resumed 
+        # exploration skips them regardless of the tuner used.
+        ckpt_tag = f'tune_{search_task}_{self.search_obj}_{self.cst}_{self.max_epochs}_{self.max_time}_' \
+                   f'{self.search_config["method"]}_{self.search_config["unit_task_method"]}'
+        state = utils.load_checkpoint(ckpt_tag)
+        if state:
+            return state["search_record"]
+
         if isinstance(search_task, SingleTask):
             if self.search_config['unit_task_method'] == "genetic":
                 # Use genetic search
@@ -85,6 +128,9 @@ class ArchExplorer(object):
             elif self.search_config["unit_task_method"] == "exhaustive_pruning":                
                 search_record = tuners.exhaustive_search(search_task, self.cst, self.search_obj, self.max_epochs, self.max_time, \
                     n_worker=1, silent=silent, pruning=1, profiling=self.search_config["profiling"])
+            elif self.search_config["unit_task_method"] == "exhaustive_bound":
+                search_record = tuners.exhaustive_search(search_task, self.cst, self.search_obj, self.max_epochs, self.max_time, \
+                    n_worker=self.search_config['n_worker'], silent=silent, pruning=2, profiling=self.search_config["profiling"])
             elif self.search_config["unit_task_method"] == "annealing":
                 search_record = tuners.annealing_search(search_task, self.cst, self.search_obj, self.max_epochs, self.max_time, \
                     n_worker=1, silent=silent, profiling=self.search_config["profiling"])
@@ -132,6 +178,8 @@ class ArchExplorer(object):
             self.search_config["search_records_db"][str(search_task)] = search_record
         '''
 
+        utils.save_checkpoint(ckpt_tag, {"search_record": search_record})
+
         return search_record
         #return search_record, self.search_config["search_records_db"]
 
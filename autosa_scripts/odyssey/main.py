@@ -18,7 +18,13 @@ if __name__ == "__main__":
     parser.add_argument('--outdir', type=str, default="outdir", help="output directory")
     parser.add_argument('--db', type=str, default="db", help="search database")
     parser.add_argument('--use-db', type=int, default=1, help="use database")
+    parser.add_argument('--eval-cache', type=str, default=None, help="persistent evaluation cache file shared by all workers")
+    parser.add_argument('--eval-cache-size', type=int, default=1048576, help="number of records in the evaluation cache")
+    parser.add_argument('--checkpoint', type=str, default=None, help="directory to checkpoint the tuner states")
+    parser.add_argument('--checkpoint-interval', type=int, default=300, help="checkpointing interval in seconds")
+    parser.add_argument('--resume', action="store_true", help="resume the search from the checkpoints")
     parser.add_argument('--objective', type=str, default="latency", help="optimization target [latency, off_chip_comm, energy, dsp_num]")
+    parser.add_argument('--pareto', action="store_true", help="search the Pareto front over latency, resource, off-chip communication, and energy")
     parser.add_argument('--cst', type=str, default="hw_cst", help="hardware constraint")
     parser.add_argument('--stop-after-epochs', type=int, default=-1, help="number of epochs of the unit searching task")
     parser.add_argument('--stop-after-time', type=int, default=-1, help="number of epochs of the unit searching task")
@@ -111,6 +117,19 @@ if __name__ == "__main__":
     else:
         search_db = None
 
+    # Set up the checkpoints
+    if args.resume and not args.checkpoint:
+        raise RuntimeError("--resume requires the checkpoint directory specified by --checkpoint.")
+    if args.checkpoint:
+        utils.set_checkpoint(args.checkpoint, args.checkpoint_interval, args.resume)
+        if args.resume:
+            logger.info(f'Resuming from checkpoints in {args.checkpoint}')
+
+    # Map the persistent evaluation cache
+    if args.eval_cache:
+        utils.set_eval_cache(args.eval_cache, args.eval_cache_size)
+        logger.info(f'Using evaluation cache {args.eval_cache}')
+
     # Start search
     counter = utils.PerfCounter(logger)
     counter.init_counter("total_search_time")
@@ -118,7 +137,7 @@ if __name__ == "__main__":
     search_config = {
         "method": args.method, # [customized1, customized2, exhaustive]
         "n_worker": args.n_worker,
-        "unit_task_method": args.unit_task_method, # [exhaustive_pruning, random, sa, bayesian, opentuner, RL]
+        "unit_task_method": args.unit_task_method, # [exhaustive_pruning, exhaustive_bound, random, sa, bayesian, opentuner, RL]
         "profiling": args.profiling,
         "workload": args.workload,
         "design_idx": args.design_idx,
@@ -142,6 +161,19 @@ if __name__ == "__main__":
     }    
 
     explorer = ArchExplorer(cst, search_obj, max_epochs, max_time, search_config, designs, workloads)
+    if args.pareto:
+        # Dump out the Pareto front of each workload
+        fronts = explorer.search_pareto(design_idx=args.design_idx)
+        counter.update_counter("total_search_time")
+        counter.print_counter("total_search_time")
+        for workload in fronts:
+            logger.info(f'Pareto front of {workload}: {len(fronts[workload])} designs')
+            for design in fronts[workload]:
+                objs = ", ".join([f'{obj}: {design["objectives"][obj]:.6g}' for obj in design["objectives"]])
+                logger.info(f'{design["design"]} {design["sa_sizes"]} ({objs})')
+        with open(f'{outdir}/pareto.json', 'w') as f:
+            json.dump(fronts, f, indent=4)
+        exit(0)
     search_record = explorer.search()
 
     # Update the database
@@ -159,6 +191,9 @@ if __name__ == "__main__":
 
     counter.update_counter("total_search_time")
     counter.print_counter("total_search_time")
+    eval_cache = utils.get_eval_cache()
+    if eval_cache:
+        logger.info(f'Evaluation cache: {eval_cache.hits} hits, {eval_cache.misses} misses in the main process')
 
     # Display and dump out the search results
     #def print_records(record, num):
@@ -9,6 +9,9 @@ from design import Design
 class SingleTask(object):
     """ Single workload searching task.
     """
+    # Objectives of the multi-objective search, all to be minimized
+    OBJECTIVES = ["latency", "DSP", "BRAM18K", "URAM", "off_chip_comm", "energy"]
+
     def __init__(self, design, workload, hw_cst):
         self.design = design
         self.workload = workload
@@ -476,6 +479,169 @@ class SingleTask(object):
         else:
             return 0, None, None        
 
+    def evaluate_cached(self, params, metric="latency"):
+        """ Evaluate the design and return the reward and resource usage only.
+        The results are looked up in and recorded to the persistent evaluation 
+        cache if enabled. The cache is keyed by the design descriptor, the task, 
+        and the parameter vector.
+        """
+        cache = utils.get_eval_cache()
+        if not cache:
+            reward, resource, _ = self.evaluate(params, metric)
+            return reward, resource
+        key = cache.make_key(f'{self.design.desp_hash}_{self}', metric, params)
+        ret = cache.lookup(key)
+        if ret:
+            return ret
+        reward, resource, _ = self.evaluate(params, metric)
+        cache.insert(key, reward, resource)
+        return reward, resource
+
+    def adjust_params_batch(self, params):
+        """ Adjust a population of parameters based on its constraints.
+        The parameters are stored as a dict of arrays, one entry per sample.
+        """
+        params = {p: np.asarray(params[p]).astype(int) for p in params}
+
+        # Making all divisor factors to be divisors of the dependent variable
+        for p, param in self.design.params_config["tunable"].items():
+            if "divisors" in param:
+                power_of_two = "tags" in param and "power_of_two" in param["tags"]
+                params[p] = utils.batch_nearest_divisor(params[p], params[param["divisors"][0]], power_of_two)
+
+        # Adjust the fixed parameters        
+        if 'fix_param' in self.configs:
+            for fix_p in self.configs['fix_param']:
+                for p, param in self.design.params_config["tunable"].items():                
+                    if p.startswith(fix_p[0]):
+                        params[p] = np.full_like(params[p], int(fix_p[1]))
+        if 'equate_params' in self.configs:
+            for p_pair in self.configs['equate_params']:
+                params[p_pair[1]] = params[p_pair[0]].copy()
+
+        return params
+
+    def evaluate_batch(self, params, metric="latency", use_cache=True):
+        """ Evaluate a population of designs in one call.
+        The parameters are stored as a dict of arrays (struct-of-arrays), one entry 
+        per sample. Return the reward array, the resource usage (dict of arrays), and 
+        the latency and activity arrays. Illegal designs are assigned with zero rewards.
+        Customized tasks (fixed architectures or extra configs) fall back to the 
+        scalar evaluation.
+        If the persistent evaluation cache is enabled and "use_cache" is set, the 
+        samples found in the cache are not evaluated again, and the rest are 
+        evaluated in one batch and recorded to the cache. The latency and activity 
+        arrays are only returned if no sample is found in the cache.
+        """
+        if metric not in ["latency", "off_chip_comm", "energy", "dsp_num"]:
+            raise RuntimeError(f"Not supported metric: {metric}")
+
+        n = utils.batch_size(params)
+        cache = utils.get_eval_cache() if use_cache else None
+        if cache and not (self.fixed == 1 or len(self.configs) > 0):
+            return self.evaluate_batch_cached(cache, params, metric)
+        if self.fixed == 1 or len(self.configs) > 0:
+            rewards = np.zeros(n)
+            resource = {"DSP": np.full(n, np.inf), "BRAM18K": np.full(n, np.inf), "URAM": np.full(n, np.inf)}
+            for i in range(n):
+                sample = {p: int(np.asarray(params[p])[i]) if np.ndim(params[p]) > 0 else params[p] for p in params}
+                reward, used_cst = self.evaluate_cached(sample, metric)
+                rewards[i] = reward
+                if used_cst:
+                    for res in resource:
+                        resource[res][i] = used_cst[res]
+            return rewards, resource, None
+
+        params = {p: np.broadcast_to(np.asarray(params[p]), (n,)) for p in params}
+        with np.errstate(divide='ignore', invalid='ignore'):
+            params, valid = self.design.infer_params_batch(params)
+            valid &= self.design.bound_check_batch(params)
+            latency, _ = self.design.est_latency_batch(params)
+            resource, _ = self.design.est_resource_batch(params)
+            activity = self.design.est_activity_batch(params)
+            resource = {res: np.broadcast_to(np.asarray(resource[res], dtype=float), (n,)) for res in resource}
+
+            if metric == "latency":
+                rewards = 1 / latency
+            elif metric == "off_chip_comm":
+                rewards = 1 / activity["off_chip_acc_num"]
+            elif metric == "energy":
+                rewards = 1 / self.compute_energy(activity)
+            elif metric == "dsp_num":
+                rewards = resource["DSP"]
+            rewards = np.broadcast_to(np.asarray(rewards, dtype=float), (n,))
+            rewards = np.where(valid & np.isfinite(rewards), rewards, 0)
+
+        return rewards, resource, {'latency': latency, 'activity': activity}
+
+    def evaluate_batch_cached(self, cache, params, metric):
+        """ Evaluate a population of designs through the persistent evaluation 
+        cache. The cache keys are the same as the ones used by evaluate_cached().
+        """
+        n = utils.batch_size(params)
+        params = {p: np.broadcast_to(np.asarray(params[p]), (n,)) for p in params}
+        task_sig = f'{self.design.desp_hash}_{self}'
+        keys = []
+        rewards = np.zeros(n)
+        resource = {"DSP": np.full(n, np.inf), "BRAM18K": np.full(n, np.inf), "URAM": np.full(n, np.inf)}
+        miss = np.zeros(n, dtype=bool)
+        for i in range(n):
+            sample = {p: int(params[p][i]) for p in params}
+            keys.append(cache.make_key(task_sig, metric, sample))
+            ret = cache.lookup(keys[i])
+            if ret is None:
+                miss[i] = True
+                continue
+            rewards[i] = ret[0]
+            if ret[1]:
+                for res in resource:
+                    resource[res][i] = ret[1][res]
+        if not miss.any():
+            return rewards, resource, None
+
+        miss_idx = np.where(miss)[0]
+        miss_rewards, miss_resource, meta = self.evaluate_batch( \
+            {p: params[p][miss_idx] for p in params}, metric, use_cache=False)
+        for j, i in enumerate(miss_idx):
+            rewards[i] = miss_rewards[j]
+            used_cst = None
+            if miss_rewards[j] > 0:
+                used_cst = {res: float(miss_resource[res][j]) for res in resource}
+                for res in resource:
+                    resource[res][i] = used_cst[res]
+            cache.insert(keys[i], float(miss_rewards[j]), used_cst)
+
+        return rewards, resource, meta if miss.all() else None
+
+    def evaluate_objectives_batch(self, params):
+        """ Evaluate all the objectives in "OBJECTIVES" of a population of designs.
+        Return the objective array of shape [#designs, #objectives] and the resource 
+        usage (dict of arrays). Illegal designs are assigned with infinite objectives.
+        """
+        n = utils.batch_size(params)
+        # The objectives need the latency and activity of all the designs.
+        rewards, resource, meta = self.evaluate_batch(params, "latency", use_cache=False)
+        valid = rewards > 0
+        objs = np.full((n, len(self.OBJECTIVES)), np.inf)
+        if meta:
+            with np.errstate(divide='ignore', invalid='ignore'):
+                objs[:, 0] = 1 / rewards
+                objs[:, 4] = np.broadcast_to(np.asarray(meta['activity']["off_chip_acc_num"], dtype=float), (n,))
+                objs[:, 5] = np.broadcast_to(np.asarray(self.compute_energy(meta['activity']), dtype=float), (n,))
+        else:
+            # Customized tasks are evaluated one by one
+            for i in np.where(valid)[0]:
+                sample = {p: int(np.asarray(params[p])[i]) if np.ndim(params[p]) > 0 else params[p] for p in params}
+                reward, _, reward_meta = self.evaluate(sample, "latency")
+                objs[i, 0] = 1 / reward
+                objs[i, 4] = reward_meta['activity']["off_chip_acc_num"]
+                objs[i, 5] = self.compute_energy(reward_meta['activity'])
+        for idx, res in enumerate(["DSP", "BRAM18K", "URAM"]):
+            objs[:, idx + 1] = resource[res]
+        objs[~valid] = np.inf
+
+        return objs, resource
+
     def compute_energy(self, activity):
         """ Estimate the energy consumption of the design.
         """           
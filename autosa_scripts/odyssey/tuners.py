@@ -14,6 +14,8 @@ import math
 import time
 from datetime import datetime
 from collections import deque
+import multiprocessing as mp
+import queue
 
 import utils
 from solver import off_chip_solver
@@ -95,6 +97,45 @@ class Tuner(object):
 
         return False
 
+    def overuse_constraint_batch(self, used_cst):
+        """ Return a mask of the designs that overuse the resource.
+        "used_cst" stores the resource usage of a population as a dict of arrays.
+        """
+        return (used_cst['BRAM18K'] > self.cst.hw_cst['BRAM18K']) | \
+               (used_cst['DSP'] > self.cst.hw_cst['DSP']) | \
+               (used_cst['URAM'] > self.cst.hw_cst['URAM'])
+
+    # Tuner states saved in the checkpoints
+    checkpoint_attrs = ["best_reward", "best_reward_meta", "best_rewards", "best_rewards_time", "best_sol", \
+                        "best_sol_cst", "last_update_epoch", "converge_time", "best_search_record"]
+
+    def checkpoint_tag(self):
+        return f'{type(self).__name__}_{self.search_task}_{self.search_obj}_{self.cst}_{self.max_epoch}_{self.max_time}_{self.params}'
+
+    def save_state(self, done=0, **extra):
+        """ Checkpoint the tuner. "extra" holds the tuner-specific search states.
+        """
+        state = {"epoch": self.epoch, "done": done, \
+                 "counters": {name: self.counter.get_counter(name) for name in self.counter.counters}}
+        state.update(extra)
+        for attr in self.checkpoint_attrs:
+            state[attr] = getattr(self, attr)
+        utils.save_checkpoint(self.checkpoint_tag(), state)
+
+    def load_state(self):
+        """ Restore the tuner from the checkpoint.
+        Return the checkpointed state, or None if there is no checkpoint.
+        """
+        state = utils.load_checkpoint(self.checkpoint_tag())
+        if state:
+            self.epoch = state["epoch"]
+            for name, elapsed in state["counters"].items():
+                self.counter.restore_counter(name, elapsed)
+            for attr in self.checkpoint_attrs:
+                setattr(self, attr, state[attr])
+            self.log(f'Resume from epoch {self.epoch}')
+        return state
+
 def exhaustive_search(search_task, cst, search_obj, max_epochs, max_time, n_worker=1, silent=0, time_out=-1, pruning=0, profiling=0):
     if profiling:
         repeat_num = 3
@@ -146,8 +187,274 @@ class ExhaustiveTuner(Tuner):
         self.idx_param_map = {} # Maps the index to the parameter name
         self.params_history = []
 
+    def bound_order(self):
+        """ Order the parameters along the tiling chains (e.g., i_t1, i_t2, j_t1, ...).
+        """
+        design = self.search_task.design
+        order = []
+        for p, param in design.params_config["external"].items():
+            cur_param = param
+            while "split_by" in cur_param and cur_param["split_by"] in design.params_config["tunable"]:
+                cur_param = design.params_config["tunable"][cur_param["split_by"]]
+                if cur_param["name"] not in order:
+                    order.append(cur_param["name"])
+        for p in design.params_config["tunable"]:
+            if p not in order:
+                order.append(p)
+        return order
+
+    def bound_choices(self, p, task_params):
+        """ Return the candidate values of the parameter "p" in ascending order,
+        given the values of the parameters assigned so far.
+        """
+        def filter_non_power_of_two(x):
+            if np.log2(x) != int(np.log2(x)):
+                return True
+            return False
+
+        param = self.search_task.design.params_config["tunable"][p]
+        lb = int(eval(param["bounds"][0], {"min": min, "max": max}, task_params))
+        ub = int(eval(param["bounds"][1], {"min": min, "max": max}, task_params))
+        if "divisors" in param:
+            power_of_two = "tags" in param and "power_of_two" in param["tags"]
+            values = utils.get_divisors(int(task_params[param["divisors"][0]]), \
+                filter_non_power_of_two if power_of_two else None)
+        else:
+            values = range(lb, ub + 1)
+        return [v for v in values if lb <= v <= ub]
+
+    def bound_prune(self, task_params, best_reward):
+        """ Return True if none of the completions of the partial assignment 
+        can fit the resource budget or beat the best reward.
+        """
+        bounds = self.search_task.design.est_bounds(task_params)
+        for res in ["DSP", "BRAM18K", "URAM"]:
+            if bounds[res] > self.cst.hw_cst[res]:
+                return True
+        if self.search_obj == "latency" and best_reward > 0 and bounds["latency"] >= 1 / best_reward:
+            return True
+        return False
+
+    def bound_init_params(self):
+        task_params = {}
+        for p, param in self.search_task.design.params_config["external"].items():
+            task_params[p] = self.search_task.workload["params"][p]
+        return task_params
+
+    def search_bound(self):
+        """ Branch-and-bound search over all the tunable parameters.
+        The parameters are assigned along the tiling chains (e.g., i_t1, i_t2, j_t1, ...).
+        At each partial assignment, the resource and latency of all the completions 
+        are bounded with interval arithmetic. The subtree is pruned if the lower bound 
+        of the resource usage exceeds the budget or the lower bound of the latency 
+        exceeds the best latency found so far.
+        """
+        if self.n_worker > 1:
+            return self.search_bound_parallel()
+        self.counter.init_counter('time')
+        self.counter.init_counter('converge_time')
+        self.epoch = 0
+        self.n_pruned = 0
+        order = self.bound_order()
+
+        def stop():
+            if self.stop_criteria == "epoch":
+                return self.epoch > self.max_epoch
+            self.counter.update_counter('time')
+            return self.counter.get_counter('time') > self.max_time
+
+        def dfs(idx, task_params):
+            if stop():
+                return
+            if idx == len(order):
+                sol = dict(task_params)
+                reward, used_constraint = self.search_task.evaluate_cached(sol, self.search_obj)
+                self.epoch += 1
+                if self.overuse_constraint(used_constraint):
+                    reward = 0
+                if reward > self.best_reward:
+                    # Re-evaluate the new best design to collect the metadata
+                    _, _, reward_meta = self.search_task.evaluate(sol, self.search_obj)
+                    self.best_reward = reward
+                    self.best_reward_meta = reward_meta
+                    self.best_sol_cst = used_constraint
+                    self.best_sol = sol
+                    self.log(f'Epoch {self.epoch}: new best reward: {self.best_reward} ({1/self.best_reward:.0f})')
+                    self.last_update_epoch = self.epoch
+                    self.counter.update_counter('converge_time')
+                    self.converge_time = self.counter.get_counter('converge_time')
+                    self.best_search_record = utils.SearchRecord().extract_from_tuner_single_acc(self)
+                self.best_rewards.append(self.best_reward)
+                self.best_rewards_time.append(self.counter.get_counter('time'))
+                return
+            p = order[idx]
+            # Visit the larger factors first to find a good incumbent early
+            for v in reversed(self.bound_choices(p, task_params)):
+                task_params[p] = v
+                # The leaves are cheaper to evaluate than to bound
+                if idx + 1 < len(order) and self.bound_prune(task_params, self.best_reward):
+                    self.n_pruned += 1
+                else:
+                    dfs(idx + 1, task_params)
+                del task_params[p]
+
+        dfs(0, self.bound_init_params())
+        self.log(f'Evaluated {self.epoch} designs, pruned {self.n_pruned} subtrees')
+
+    def bound_worker(self, order, task_queue, ret_queue, shared):
+        """ Worker of the parallel branch-and-bound search.
+        Each task is a subtree given by the values of the first "level" parameters 
+        and the candidate values of the next one. The worker explores the subtree 
+        depth-first with an explicit stack. Whenever some workers are idle, it splits 
+        off the unexplored siblings at the shallowest level of its stack, which are 
+        the largest subtrees left, and pushes them to the task queue.
+        """
+        epoch = 0
+        n_pruned = 0
+        n_donated = 0
+        best_reward = 0
+        best_sol = None
+        best_sol_cst = None
+        history = [] # (epoch, time, reward) of each improvement found by this worker
+        stopped = False
+
+        def stop():
+            if self.stop_criteria == "epoch":
+                return shared["epoch"].value > self.max_epoch
+            self.counter.update_counter('time')
+            return self.counter.get_counter('time') > self.max_time
+
+        while True:
+            with shared["lock"]:
+                if shared["n_active"].value == 0:
+                    break
+                shared["n_idle"].value += 1
+            try:
+                level, prefix, values = task_queue.get(timeout=0.01)
+            except queue.Empty:
+                with shared["lock"]:
+                    shared["n_idle"].value -= 1
+                continue
+            with shared["lock"]:
+                shared["n_idle"].value -= 1
+
+            task_params = self.bound_init_params()
+            for p, v in zip(order, prefix):
+                task_params[p] = v
+            stack = [values]
+            n_visit = 0
+            while stack and not stopped:
+                n_visit += 1
+                if n_visit % 16 == 0 and shared["n_idle"].value > 0:
+                    # Donate the shallowest unexplored siblings that are not leaves
+                    for d in range(len(stack)):
+                        if level + d + 1 < len(order) and stack[d]:
+                            n_split = (len(stack[d]) + 1) // 2
+                            donated = stack[d][:n_split]
+                            del stack[d][:n_split]
+                            with shared["lock"]:
+                                shared["n_active"].value += 1
+                            task_queue.put((level + d, [task_params[p] for p in order[:level + d]], donated))
+                            n_donated += 1
+                            break
+
+                cur_level = level + len(stack) - 1
+                frame = stack[-1]
+                if not frame:
+                    stack.pop()
+                    task_params.pop(order[cur_level], None)
+                    continue
+                # Visit the larger factors first to find a good incumbent early
+                task_params[order[cur_level]] = frame.pop()
+                if cur_level + 1 == len(order):
+                    sol = dict(task_params)
+                    reward, used_constraint = self.search_task.evaluate_cached(sol, self.search_obj)
+                    epoch += 1
+                    with shared["lock"]:
+                        shared["epoch"].value += 1
+                    if self.overuse_constraint(used_constraint):
+                        reward = 0
+                    if reward > best_reward:
+                        best_reward = reward
+                        best_sol = sol
+                        best_sol_cst = used_constraint
+                        self.counter.update_counter('time')
+                        history.append((shared["epoch"].value, self.counter.get_counter('time'), reward))
+                        with shared["lock"]:
+                            if reward > shared["best_reward"].value:
+                                shared["best_reward"].value = reward
+                    if stop():
+                        stopped = True
+                    continue
+                # The leaves are cheaper to evaluate than to bound
+                if self.bound_prune(task_params, shared["best_reward"].value):
+                    n_pruned += 1
+                    continue
+                stack.append(self.bound_choices(order[cur_level + 1], task_params))
+
+            with shared["lock"]:
+                shared["n_active"].value -= 1
+
+        ret_queue.put({"best_reward": best_reward, "best_sol": best_sol, "best_sol_cst": best_sol_cst, \
+                       "epoch": epoch, "n_pruned": n_pruned, "n_donated": n_donated, "history": history})
+
+    def search_bound_parallel(self):
+        """ Parallel branch-and-bound search with "n_worker" processes.
+        The workers share the best reward found so far for pruning and balance 
+        the load by work stealing, since the feasible designs are usually 
+        concentrated in a few branches of the search tree.
+        """
+        self.counter.init_counter('time')
+        self.counter.init_counter('converge_time')
+        order = self.bound_order()
+        task_queue = mp.Queue()
+        ret_queue = mp.Queue()
+        shared = {
+            "lock": mp.Lock(),
+            "best_reward": mp.Value('d', 0, lock=False),
+            "n_active": mp.Value('i', 1, lock=False),
+            "n_idle": mp.Value('i', 0, lock=False),
+            "epoch": mp.Value('i', 0, lock=False)
+        }
+        task_queue.put((0, [], self.bound_choices(order[0], self.bound_init_params())))
+
+        proc_list = []
+        for i in range(self.n_worker):
+            p = utils.NoDaemonProcess(target=self.bound_worker, args=(order, task_queue, ret_queue, shared))
+            p.start()
+            proc_list.append(p)
+        results = [ret_queue.get() for i in range(self.n_worker)]
+        for p in proc_list:
+            p.join()
+
+        self.epoch = sum([ret["epoch"] for ret in results])
+        self.n_pruned = sum([ret["n_pruned"] for ret in results])
+        history = sorted([h for ret in results for h in ret["history"]])
+        for epoch, elapsed, reward in history:
+            if reward > self.best_reward:
+                self.best_reward = reward
+                self.last_update_epoch = epoch
+                self.converge_time = elapsed
+                self.best_rewards.append(reward)
+                self.best_rewards_time.append(elapsed)
+        best = max(results, key=lambda ret: ret["best_reward"])
+        if best["best_reward"] > 0:
+            sol = best["best_sol"]
+            # Re-evaluate the best design to collect the metadata
+            _, _, reward_meta = self.search_task.evaluate(sol, self.search_obj)
+            self.best_reward = best["best_reward"]
+            self.best_reward_meta = reward_meta
+            self.best_sol_cst = best["best_sol_cst"]
+            self.best_sol = sol
+            self.log(f'Epoch {self.last_update_epoch}: new best reward: {self.best_reward} ({1/self.best_reward:.0f})')
+            self.best_search_record = utils.SearchRecord().extract_from_tuner_single_acc(self)
+        self.log(f'Evaluated {self.epoch} designs, pruned {self.n_pruned} subtrees, ' \
+                 f'{sum([ret["n_donated"] for ret in results])} subtrees stolen')
+
     def search(self):
         """ This tuner only works for GEMM (kernel3) """
+        if self.params["pruning"] == 2:
+            return self.search_bound()
         self.counter.init_counter('time')
         self.counter.init_counter('converge_time')
         self.epoch = 0
@@ -375,10 +682,12 @@ class RandomTuner(Tuner):
                 # Design space is exhausted
                 break
             task_params = self.search_task.adjust_params(task_params)
-            reward, used_constraint, reward_meta = self.search_task.evaluate(task_params, self.search_obj)
+            reward, used_constraint = self.search_task.evaluate_cached(task_params, self.search_obj)
             if self.overuse_constraint(used_constraint):
                 reward = 0
             if reward > self.best_reward:
+                # Re-evaluate the new best design to collect the metadata
+                _, _, reward_meta = self.search_task.evaluate(task_params, self.search_obj)
                 self.best_reward = reward
                 self.best_reward_meta = reward_meta
                 self.best_sol_cst = used_constraint
@@ -522,6 +831,9 @@ class AnnealingTuner(Tuner):
             self.counter.update_counter('converge_time')
             self.converge_time = self.counter.get_counter('converge_time')
             self.best_search_record = utils.SearchRecord().extract_from_tuner_single_acc(self)        
+        if utils.checkpoint_due(self.last_save):
+            self.save_state(x=x)
+            self.last_save = time.time()
 
     def take_step(self, x):
         """ Step-taking routine.
@@ -638,29 +950,39 @@ class AnnealingTuner(Tuner):
             self.idx_param_map[idx] = param["name"]
             idx += 1
 
-        # Init guess
-        init_reward = 0
-        init_params = None
-        for i in range(5):
-            task_params = self.search_task.generate_random_sample()
-            task_params = self.search_task.adjust_params(task_params)
-            reward, used_constraint, reward_meta = self.search_task.evaluate(task_params, self.search_obj)
-            if self.overuse_constraint(used_constraint):
-                reward = 0
-            if reward > init_reward:
-                init_reward = reward
-                init_params = task_params
+        # The annealing states inside basinhopping are not exposed. When resuming, 
+        # restart basinhopping from the last local minimum with the remaining iterations.
+        state = self.load_state()
+        if state:
+            if state["done"]:
+                return
+            x0 = state["x"]
+        else:
+            # Init guess
+            init_reward = 0
+            init_params = None
+            for i in range(5):
+                task_params = self.search_task.generate_random_sample()
+                task_params = self.search_task.adjust_params(task_params)
+                reward, used_constraint, reward_meta = self.search_task.evaluate(task_params, self.search_obj)
+                if self.overuse_constraint(used_constraint):
+                    reward = 0
+                if reward > init_reward:
+                    init_reward = reward
+                    init_params = task_params
 
-        param_arr = []
-        for p, param in self.search_task.design.params_config["tunable"].items():
-            param_arr.append(task_params[param["name"]])
-        x0 = np.array(param_arr)
+            param_arr = []
+            for p, param in self.search_task.design.params_config["tunable"].items():
+                param_arr.append(task_params[param["name"]])
+            x0 = np.array(param_arr)
+        self.last_save = time.time()
         # Search
-        optimize.basinhopping(self.update, x0, niter=self.max_epoch, \
+        optimize.basinhopping(self.update, x0, niter=max(self.max_epoch - self.epoch, 0), \
                 accept_test=self.bound_check,
                 stepsize=self.params['stepsize'],
                 T=self.params['T'], callback=self.print_minimal,
                 take_step=self.take_step)
+        self.save_state(done=1, x=x0)
 
         return
 
@@ -1391,33 +1713,9 @@ class GeneticTuner(Tuner):
 
         return pool
 
-    def search(self):
-        """ Search the design space using genetic algorithms.
-
-        The algorithm is configured by several parameters.
-        @ population_size: the number of trial solutions in each epoch.
-        @ mutation_probability: the chance of each gene in each individual solution
-        to be replaced by a random value.
-        @ crossover_probability: the chance of an existed solution to pass its genome
-        to new trial solutions.
-        @ parents_ratio: the ratio of population filled by the members of the previous
-        generation.
+    def init_population(self, num_pop):
+        """ Initialize the population with the ancestor or random samples.
         """
-        self.counter.init_counter('time')
-        self.counter.init_counter('converge_time')
-        self.epoch = 0
-        # Internal testing
-        #local_reward = 0
-
-        # Init the stats
-        num_pop = int(self.params["population_size"])
-        num_gen = int(self.max_epoch // num_pop)
-        num_parents = int(num_pop * self.params["parents_ratio"])
-        self.log(f'Number of generations: {num_gen}')
-        self.log(f'Number of population: {num_pop}')
-        self.log(f'Number of parents: {num_parents}')
-
-        # Init the population
         population = np.empty((num_pop, len(self.search_task.design.params_config["tunable"])), dtype=int)
         if "ancestor" in self.params and self.params["ancestor"] != None:
             # Initialize the population with the ancestor
@@ -1455,8 +1753,60 @@ class GeneticTuner(Tuner):
             self.idx_param_map[idx] = param["name"]
             idx += 1
 
+        return population
+
+    def population_to_params(self, population):
+        """ Convert the population to the adjusted parameters (dict of arrays).
+        """
+        batch_params = {}
+        for p, param in self.search_task.design.params_config["tunable"].items():
+            batch_params[param["name"]] = population[:, self.param_idx_map[param["name"]]]
+        for p, param in self.search_task.design.params_config["external"].items():
+            batch_params[param["name"]] = np.full(population.shape[0], self.search_task.workload["params"][param["name"]])
+        return self.search_task.adjust_params_batch(batch_params)
+
+    def save_state(self, population, scores, done=0):
+        """ Checkpoint the tuner at the end of a generation.
+        """
+        super().save_state(done, population=population, scores=scores)
+
+    def search(self):
+        """ Search the design space using genetic algorithms.
+
+        The algorithm is configured by several parameters.
+        @ population_size: the number of trial solutions in each epoch.
+        @ mutation_probability: the chance of each gene in each individual solution
+        to be replaced by a random value.
+        @ crossover_probability: the chance of an existed solution to pass its genome
+        to new trial solutions.
+        @ parents_ratio: the ratio of population filled by the members of the previous
+        generation.
+        """
+        self.counter.init_counter('time')
+        self.counter.init_counter('converge_time')
+        self.epoch = 0
+        # Internal testing
+        #local_reward = 0
+
+        # Init the stats
+        num_pop = int(self.params["population_size"])
+        num_gen = int(self.max_epoch // num_pop)
+        num_parents = int(num_pop * self.params["parents_ratio"])
+        self.log(f'Number of generations: {num_gen}')
+        self.log(f'Number of population: {num_pop}')
+        self.log(f'Number of parents: {num_parents}')
+
+        population = self.init_population(num_pop)
+
         fitness = np.empty(num_pop, dtype=float)
 
+        state = self.load_state()
+        if state:
+            if state["done"]:
+                return
+            population, fitness = state["population"], state["scores"]
+        last_save = time.time()
+
         terminate = False
         while True:
             if self.epoch > 0:
@@ -1473,21 +1823,18 @@ class GeneticTuner(Tuner):
                 population[parents.shape[0]:, :] = children
 
             # Update the fitness
+            # Evaluate the whole population at once, and only re-evaluate the 
+            # new best designs one by one to collect their meta information.
+            batch_params = self.population_to_params(population)
+            batch_rewards, batch_used_constraint, _ = self.search_task.evaluate_batch(batch_params, self.search_obj)
+            batch_rewards = np.where(self.overuse_constraint_batch(batch_used_constraint), 0, batch_rewards)
             for i in range(num_pop):
-                idv = population[i]
-                task_params = {}
-                for p, param in self.search_task.design.params_config["tunable"].items():
-                    task_params[param["name"]] = idv[self.param_idx_map[param["name"]]]
-                for p, param in self.search_task.design.params_config["external"].items():
-                    task_params[param["name"]] = self.search_task.workload["params"][param["name"]]
-                task_params = self.search_task.adjust_params(task_params)
-                reward, used_constraint, reward_meta = self.search_task.evaluate(task_params, self.search_obj)
-                #print(reward, used_constraint)
-                #pprint.pprint(reward_meta)
-                #print(task_params)
-                #exit(0)
-                if self.overuse_constraint(used_constraint):
-                    reward = 0
+                reward = batch_rewards[i]
+                if reward > self.best_reward:
+                    task_params = {p: int(batch_params[p][i]) for p in batch_params}
+                    reward, used_constraint, reward_meta = self.search_task.evaluate(task_params, self.search_obj)
+                    if self.overuse_constraint(used_constraint):
+                        reward = 0
                 # Internal testing
                 #reward_old = reward
                 #if reward:
@@ -1533,6 +1880,135 @@ class GeneticTuner(Tuner):
                     break
             if terminate:
                 break
+            if utils.checkpoint_due(last_save):
+                self.save_state(population, fitness)
+                last_save = time.time()
+
+        self.save_state(population, fitness, done=1)
+
+        return
+
+def pareto_search(search_task, cst, max_epochs, max_time, n_worker=1, silent=0, population_size=200, archive_size=200):
+    """ Multi-objective genetic search
+    Search the Pareto front over the objectives in SingleTask.OBJECTIVES.
+    Return a list of Pareto-optimal designs sorted by latency.
+    """
+    tuner_params = {
+        "population_size": population_size,\
+        "mutation_probability": 0.5,\
+        "parents_ratio": 0.3,\
+        "epsilon": 0.1,\
+        "ancestor": None,\
+        "time_out": -1,
+        "mutation_probs": [0.2, 0.8, 0],
+        "archive_size": archive_size
+    }
+    tuner = ParetoGeneticTuner(search_task, cst, "latency", max_epochs, max_time, tuner_params, n_worker, silent)
+    tuner.search()
+
+    return tuner.pareto_front()
+
+class ParetoGeneticTuner(GeneticTuner):
+    """ Multi-objective genetic tuner.
+    The parents are selected by the non-dominated sorting and the crowding distance 
+    (NSGA-II). All the non-dominated designs found are kept in the Pareto archive.
+    """
+    def __init__(self, search_task, cst, obj, max_epoch, max_time, params, n_worker=1, silent=0):
+        super().__init__(search_task, cst, obj, max_epoch, max_time, params, n_worker=n_worker, silent=silent)
+        self.archive_objs = np.empty((0, len(SingleTask.OBJECTIVES)))
+        self.archive_sols = []
+        self.checkpoint_attrs = self.checkpoint_attrs + ["archive_objs", "archive_sols"]
+
+    def update_archive(self, batch_params, objs):
+        """ Merge the feasible designs into the archive and keep the non-dominated ones.
+        """
+        known = set(tuple(sorted(sol.items())) for sol in self.archive_sols)
+        sols = list(self.archive_sols)
+        idx = [i for i in range(len(sols))]
+        new_objs = [self.archive_objs]
+        for i in np.where(np.all(np.isfinite(objs), axis=1))[0]:
+            sol = {p: int(batch_params[p][i]) for p in batch_params}
+            key = tuple(sorted(sol.items()))
+            if key in known:
+                continue
+            known.add(key)
+            sols.append(sol)
+            new_objs.append(objs[i:i + 1])
+        all_objs = np.concatenate(new_objs)
+        if all_objs.shape[0] == len(self.archive_sols):
+            return False
+        front = np.where(utils.non_dominated_sort(all_objs) == 0)[0]
+        if len(front) > self.params["archive_size"]:
+            # Keep the least crowded designs
+            dist = utils.crowding_distance(all_objs[front], np.zeros(len(front), dtype=int))
+            front = front[np.argsort(-dist, kind='stable')[:self.params["archive_size"]]]
+        updated = set(front) != set(range(len(self.archive_sols)))
+        self.archive_objs = all_objs[front]
+        self.archive_sols = [sols[i] for i in front]
+
+        return updated
+
+    def pareto_front(self):
+        """ Return the designs in the archive sorted by latency.
+        """
+        front = []
+        for i in np.argsort(self.archive_objs[:, 0], kind='stable'):
+            front.append({
+                "design": self.search_task.design.name,
+                "workload": self.search_task.workload["name"],
+                "sol": self.archive_sols[i],
+                "objectives": {obj: float(self.archive_objs[i][idx]) for idx, obj in enumerate(SingleTask.OBJECTIVES)},
+                "sa_sizes": self.search_task.design.sa_sizes(self.archive_sols[i])
+            })
+
+        return front
+
+    def search(self):
+        self.counter.init_counter('time')
+        self.epoch = 0
+
+        num_pop = int(self.params["population_size"])
+        num_parents = int(num_pop * self.params["parents_ratio"])
+        population = self.init_population(num_pop)
+        order = None
+
+        state = self.load_state()
+        if state:
+            if state["done"]:
+                return
+            population, order = state["population"], state["scores"]
+        last_save = time.time()
+
+        while True:
+            if self.epoch > 0:
+                # Select the parents by Pareto rank and crowding distance
+                parents = population[order[:num_parents]]
+                children = self.crossover(parents, num_pop - parents.shape[0])
+                children = self.mutation(children)
+                population[0:parents.shape[0], :] = parents
+                population[parents.shape[0]:, :] = children
+
+            batch_params = self.population_to_params(population)
+            with np.errstate(invalid='ignore'):
+                objs, resource = self.search_task.evaluate_objectives_batch(batch_params)
+                objs[self.overuse_constraint_batch(resource)] = np.inf
+                if self.update_archive(batch_params, objs):
+                    self.log(f'Epoch {self.epoch}: Pareto front size: {len(self.archive_sols)}')
+                ranks = utils.non_dominated_sort(objs)
+                dist = utils.crowding_distance(objs, ranks)
+            order = np.lexsort((-dist, ranks))
+
+            self.epoch += num_pop
+            self.counter.update_counter('time')
+            if self.stop_criteria == "epoch" and self.epoch > self.max_epoch:
+                break
+            if self.stop_criteria == "time" and self.counter.get_counter('time') > self.max_time:
+                break
+            if utils.checkpoint_due(last_save):
+                self.save_state(population, order)
+                last_save = time.time()
+
+        self.save_state(population, order, done=1)
 
         return
 
@@ -1818,6 +2294,39 @@ class MultiWorkloadArrayGeneticTuner(GeneticTuner):
             hash_str += f'{k}{v}'
         return hash_str
 
+    def shared_cache_key(self, sol):
+        """ Return the persistent evaluation cache and the key of the array 
+        architecture "sol" searched over all the workloads. 
+        Return (None, None) if the cache is disabled.
+        """
+        cache = utils.get_eval_cache()
+        if not cache:
+            return None, None
+        arch_sol = {param["name"]: sol[param["name"]] \
+                    for p, param in self.search_task.design.params_config["tunable"].items()}
+        key = cache.make_key(f'{type(self).__name__}_{self.search_task.design.desp_hash}_{self.search_task}', \
+                             self.search_obj, arch_sol)
+        return cache, key
+
+    def lookup_shared_cache(self, sol):
+        """ Look up the network reward of the array architecture "sol" in the 
+        persistent evaluation cache, which is shared by all the processes and 
+        repeated runs. Return None if not found.
+        """
+        cache, key = self.shared_cache_key(sol)
+        if not cache:
+            return None
+        ret = cache.lookup(key)
+        return ret[0] if ret else None
+
+    def record_shared_cache(self, sol, search_record):
+        """ Record the network search result of the array architecture "sol" in 
+        the persistent evaluation cache.
+        """
+        cache, key = self.shared_cache_key(sol)
+        if cache:
+            cache.insert(key, search_record.reward, search_record.cst)
+
     def search_design(self, arch_sol, use_model=0, bst=None):
         """ Search the optimal task configuration in the fixed array.
         """
@@ -1937,6 +2446,13 @@ class MultiWorkloadArrayGeneticTuner(GeneticTuner):
                 if not use_model:
                     if idv_hash in self.search_cache:
                         continue
+                    # Reuse the architectures searched by other processes or 
+                    # previous runs. Architectures better than the current best 
+                    # one are searched again to restore their search records.
+                    shared_reward = self.lookup_shared_cache(task_params)
+                    if shared_reward is not None and shared_reward <= self.best_reward:
+                        self.search_cache[idv_hash] = {'status': 'done', 'value': shared_reward / self.params['best_reward']}
+                        continue
                     else:
                         search_record = utils.SearchRecord(self.max).reset()
                         if arch_cst:
@@ -2018,6 +2534,7 @@ class MultiWorkloadArrayGeneticTuner(GeneticTuner):
                     self.best_rewards_time.append(self.counter.get_counter('time'))
                     fitness[i] = search_record.reward / self.params['best_reward']
                     self.search_cache[idv_hash] = {'status': 'done', 'value': fitness[i]}
+                    self.record_shared_cache(task_params, search_record)
                     if terminate:
                         break
                 self.epoch += 1
@@ -3,6 +3,7 @@ import copy
 from search_task import SingleTask
 from design import Design
 import json
+import re
 from tuners import Constraint
 
 class Workload(object):
@@ -74,5 +75,35 @@ def est_mm_performance():
     print(resource)
     print(meta)
 
+def test_sa_sizes():
+    """ Check that the AutoSA arguments of the design "kernel0_1" round-trip, i.e., 
+    the space-time transformation, the loop ordering, and the tiling factors can be 
+    recovered from them.
+    """
+    kernel_name = "kernel0_1"
+    with open(f"designs_lib/cnn/{kernel_name}.json", "r") as json_f:
+        desp = json.load(json_f)
+    design = Design(kernel_name)
+    design.desp = desp
+    params = {p["name"]: 2 for p in desp["params"]}
+    sa_sizes = design.sa_sizes(params)
+    print(sa_sizes)
+
+    match = re.fullmatch(r'--sa-sizes="\{(.*)\}" --explore-loop-permute --loop-permute-order=(\d+)', sa_sizes)
+    assert match, sa_sizes
+    assert f"kernel{match.group(1).split(';')[0][len('kernel[]->space_time['):-1]}_{match.group(2)}" == kernel_name, sa_sizes
+    stages = {"array_part": "array_part_tiling_factor", "latency": "latency_tiling_factor", \
+              "simd": "SIMD_tiling_factor"}
+    for size in match.group(1).split(';')[1:]:
+        stage, factors = re.fullmatch(r"kernel\[\]->(\w+)\[(.*)\]", size).groups()
+        names = [p["name"] for p in desp["params"] if p["attr"] == stages[stage]]
+        assert [int(f) for f in factors.split(',')] == [params[name] for name in names], sa_sizes
+
+    # Designs without the loop ordering don't explore the loop permutation.
+    design = Design("kernel0")
+    design.desp = desp
+    assert "loop-permute" not in design.sa_sizes(params)
+
 if __name__ == "__main__":
+    test_sa_sizes()
     est_mm_performance()
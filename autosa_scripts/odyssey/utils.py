@@ -11,6 +11,14 @@ import queue
 import multiprocessing as mp
 from pathos.pools import ProcessPool, ParallelPool
 import copy
+import numpy as np
+import os
+import mmap
+import fcntl
+import struct
+import hashlib
+import pickle
+import random
 
 def factorization(x):
     if x == 0:
@@ -48,6 +56,203 @@ def get_divisors(x, filter=None):
 
     return divisors
 
+def batch_size(params):
+    """ Return the number of samples in the struct-of-arrays parameters.
+    """
+    return np.broadcast(*[np.asarray(v) for v in params.values()]).shape[0]
+
+def batch_max(*args):
+    """ Element-wise max() used by the batch evaluation functions.
+    """
+    if len(args) == 1:
+        return np.asarray(args[0])
+    return functools.reduce(np.maximum, args)
+
+def batch_min(*args):
+    """ Element-wise min() used by the batch evaluation functions.
+    """
+    if len(args) == 1:
+        return np.asarray(args[0])
+    return functools.reduce(np.minimum, args)
+
+def batch_non_power_of_two(x):
+    """ Return a mask of the elements in x that are not powers of two.
+    """
+    x = np.maximum(np.asarray(x, dtype=float), 1)
+    return np.log2(x) != np.floor(np.log2(x))
+
+def batch_max_multiple_divisor(lb, ub):
+    """ For each pair of (lb, ub), return the largest multiple of lb that 
+    divides ub, and a mask of the pairs that have such a number.
+    """
+    lb, ub = np.broadcast_arrays(np.asarray(lb, dtype=np.int64), np.asarray(ub, dtype=np.int64))
+    ret = np.zeros(ub.shape, dtype=np.int64)
+    if ub.size == 0:
+        return ret, ret > 0
+    n_max = int(np.max(ub // np.maximum(lb, 1)))
+    for n in range(1, n_max + 1):
+        cand = n * lb
+        legal = (cand > 0) & (cand <= ub)
+        legal &= (ub % np.where(cand > 0, cand, 1)) == 0
+        ret = np.where(legal, cand, ret)
+
+    return ret, ret > 0
+
+@functools.lru_cache(maxsize=None)
+def _batch_divisors(x, power_of_two):
+    def filter_non_power_of_two(d):
+        return (d & (d - 1)) != 0
+
+    return np.array(get_divisors(x, filter_non_power_of_two if power_of_two else None), dtype=np.int64)
+
+def batch_nearest_divisor(x, dividend, power_of_two=False):
+    """ Round each element in x to a divisor of the corresponding dividend.
+    It follows the same rule as SingleTask.adjust_params for single samples.
+    """
+    x, dividend = np.broadcast_arrays(np.asarray(x, dtype=np.int64), np.asarray(dividend, dtype=np.int64))
+    ret = np.zeros(x.shape, dtype=np.int64)
+    # Group the samples by their dividends
+    uniq, inverse = np.unique(dividend, return_inverse=True)
+    inverse = inverse.reshape(-1)
+    order = np.argsort(inverse, kind='stable')
+    bounds = np.searchsorted(inverse[order], np.arange(len(uniq) + 1))
+    for k, u in enumerate(uniq):
+        if u <= 0:
+            continue
+        idx = order[bounds[k]:bounds[k + 1]]
+        choices = _batch_divisors(int(u), power_of_two)
+        v = x[idx]
+        pos = np.minimum(np.searchsorted(choices, v, side='right'), len(choices) - 1)
+        lower = choices[np.maximum(pos - 1, 0)]
+        upper = choices[pos]
+        ret[idx] = np.where((pos > 1) & (np.abs(lower - v) < np.abs(upper - v)), lower, upper)
+
+    return ret
+
+def non_dominated_sort(objs):
+    """ Return the Pareto rank of each design (rank 0 is the Pareto front).
+    "objs" is an array of shape [#designs, #objectives], all to be minimized.
+    """
+    n = objs.shape[0]
+    # dom[i, j]: design i dominates design j
+    dom = np.all(objs[:, None, :] <= objs[None, :, :], axis=2) & \
+          np.any(objs[:, None, :] < objs[None, :, :], axis=2)
+    n_dom = dom.sum(axis=0)
+    ranks = np.full(n, -1)
+    rank = 0
+    front = np.where(n_dom == 0)[0]
+    while len(front) > 0:
+        ranks[front] = rank
+        n_dom = n_dom - dom[front].sum(axis=0)
+        n_dom[ranks >= 0] = -1
+        front = np.where(n_dom == 0)[0]
+        rank += 1
+
+    return ranks
+
+def crowding_distance(objs, ranks):
+    """ Return the crowding distance of each design within its Pareto front.
+    The boundary designs of each front are assigned with an infinite distance.
+    """
+    dist = np.zeros(objs.shape[0])
+    for rank in np.unique(ranks):
+        idx = np.where(ranks == rank)[0]
+        for m in range(objs.shape[1]):
+            order = idx[np.argsort(objs[idx, m], kind='stable')]
+            span = objs[order[-1], m] - objs[order[0], m]
+            dist[order[0]] = dist[order[-1]] = np.inf
+            if len(order) > 2 and span > 0:
+                dist[order[1:-1]] += (objs[order[2:], m] - objs[order[:-2], m]) / span
+
+    return dist
+
+class Interval(object):
+    """ Closed interval [lo, hi] used to bound the performance models over the 
+    parameters that are not assigned yet.
+    """
+    __slots__ = ('lo', 'hi')
+
+    def __init__(self, lo, hi=None):
+        self.lo = lo
+        self.hi = lo if hi is None else hi
+
+    @staticmethod
+    def wrap(x):
+        return x if isinstance(x, Interval) else Interval(x)
+
+    def __add__(self, other):
+        if isinstance(other, Interval):
+            return Interval(self.lo + other.lo, self.hi + other.hi)
+        return Interval(self.lo + other, self.hi + other)
+
+    def __sub__(self, other):
+        if isinstance(other, Interval):
+            return Interval(self.lo - other.hi, self.hi - other.lo)
+        return Interval(self.lo - other, self.hi - other)
+
+    def __mul__(self, other):
+        if not isinstance(other, Interval):
+            if other == 0:
+                return Interval(0)
+            return Interval(self.lo * other, self.hi * other) if other > 0 else Interval(self.hi * other, self.lo * other)
+        if self.lo >= 0 and other.lo >= 0:
+            # Non-negative intervals, the most common case; 0 * inf is taken as 0
+            lo = 0 if self.lo == 0 or other.lo == 0 else self.lo * other.lo
+            hi = 0 if self.hi == 0 or other.hi == 0 else self.hi * other.hi
+            return Interval(lo, hi)
+        prods = [0 if (a == 0 or b == 0) else a * b for a in [self.lo, self.hi] for b in [other.lo, other.hi]]
+        return Interval(min(prods), max(prods))
+
+    def __truediv__(self, other):
+        if not isinstance(other, Interval):
+            other = Interval(other)
+        if other.lo <= 0 <= other.hi:
+            return Interval(-math.inf, math.inf)
+        if self.lo >= 0 and other.lo > 0:
+            return Interval(self.lo / other.hi, self.hi / other.lo)
+        return self * Interval(1 / other.hi, 1 / other.lo)
+
+    def __floordiv__(self, other):
+        return math.floor(self / other)
+
+    def __mod__(self, other):
+        other = Interval.wrap(other)
+        return Interval(0, max(other.hi - 1, 0))
+
+    def __neg__(self):
+        return Interval(-self.hi, -self.lo)
+
+    def __radd__(self, other):
+        return self + other
+
+    def __rsub__(self, other):
+        return Interval(other - self.hi, other - self.lo)
+
+    def __rmul__(self, other):
+        return self * other
+
+    def __rtruediv__(self, other):
+        return Interval.wrap(other) / self
+
+    def __ceil__(self):
+        return Interval(math.ceil(self.lo) if math.isfinite(self.lo) else self.lo, \
+                        math.ceil(self.hi) if math.isfinite(self.hi) else self.hi)
+
+    def __floor__(self):
+        return Interval(math.floor(self.lo) if math.isfinite(self.lo) else self.lo, \
+                        math.floor(self.hi) if math.isfinite(self.hi) else self.hi)
+
+    def __repr__(self):
+        return f'[{self.lo}, {self.hi}]'
+
+def interval_max(*args):
+    args = [Interval.wrap(x) for x in args]
+    return Interval(max(x.lo for x in args), max(x.hi for x in args))
+
+def interval_min(*args):
+    args = [Interval.wrap(x) for x in args]
+    return Interval(min(x.lo for x in args), min(x.hi for x in args))
+
 def compute_tasks_latency(search_tasks, init_tasks):
     """ Aggregate the best latency of the search tasks.
     """
@@ -92,6 +297,166 @@ def compute_tasks_latency(search_tasks, init_tasks):
 
     return latency
 
+class EvalCache(object):
+    """ Persistent design evaluation cache shared by all the tuner processes.
+    The cache is an open-addressing hash table stored in a memory-mapped file.
+    Each record holds a 16-byte key digest followed by the reward and the 
+    DSP/BRAM18K/URAM usage as doubles. Missing resource usage is stored as NaN.
+    Lookups are lock-free, inserts are serialized with a file lock. The value 
+    is written before the key so that readers never see a partial record.
+    """
+    MAGIC = b'ODYCACHE'
+    VERSION = 1
+    HEADER = struct.Struct('<8sIIQ')
+    HEADER_SIZE = 64
+    KEY_SIZE = 16
+    VALUE = struct.Struct('<dddd')
+    RECORD_SIZE = KEY_SIZE + VALUE.size
+    MAX_PROBE = 64
+
+    def __init__(self, path, capacity=1 << 20):
+        self.path = path
+        self.hits = 0
+        self.misses = 0
+        self.drops = 0
+        # Round up the capacity to a power of two
+        capacity = 1 << max(int(capacity) - 1, 1).bit_length()
+        self.fd = os.open(path, os.O_RDWR | os.O_CREAT, 0o644)
+        fcntl.flock(self.fd, fcntl.LOCK_EX)
+        try:
+            if os.fstat(self.fd).st_size == 0:
+                os.ftruncate(self.fd, self.HEADER_SIZE + capacity * self.RECORD_SIZE)
+                os.pwrite(self.fd, self.HEADER.pack(self.MAGIC, self.VERSION, self.RECORD_SIZE, capacity), 0)
+            magic, version, record_size, capacity = self.HEADER.unpack(os.pread(self.fd, self.HEADER.size, 0))
+            if magic != self.MAGIC or version != self.VERSION or record_size != self.RECORD_SIZE:
+                raise RuntimeError(f"Incompatible evaluation cache file: {path}")
+        finally:
+            fcntl.flock(self.fd, fcntl.LOCK_UN)
+        self.capacity = capacity
+        self.buf = mmap.mmap(self.fd, self.HEADER_SIZE + capacity * self.RECORD_SIZE)
+
+    @staticmethod
+    def make_key(task_sig, metric, params):
+        """ Hash the task signature, the metric, and the parameter vector.
+        """
+        h = hashlib.blake2b(digest_size=EvalCache.KEY_SIZE)
+        h.update(f'{task_sig}|{metric}|'.encode())
+        for p in sorted(params):
+            h.update(f'{p}={params[p]};'.encode())
+        key = h.digest()
+        # All-zero keys mark empty slots
+        return key if any(key) else b'\x01' + key[1:]
+
+    def slots(self, key):
+        idx = int.from_bytes(key[:8], 'little') & (self.capacity - 1)
+        for i in range(min(self.MAX_PROBE, self.capacity)):
+            yield self.HEADER_SIZE + ((idx + i) & (self.capacity - 1)) * self.RECORD_SIZE
+
+    def lookup(self, key):
+        """ Return (reward, resource) if the key is found, otherwise None.
+        """
+        for off in self.slots(key):
+            slot_key = self.buf[off: off + self.KEY_SIZE]
+            if slot_key == key:
+                reward, dsp, bram, uram = self.VALUE.unpack_from(self.buf, off + self.KEY_SIZE)
+                self.hits += 1
+                if math.isnan(dsp):
+                    return reward, None
+                return reward, {"DSP": dsp, "BRAM18K": bram, "URAM": uram}
+            if not any(slot_key):
+                break
+        self.misses += 1
+        return None
+
+    def insert(self, key, reward, resource):
+        if resource:
+            value = self.VALUE.pack(reward, resource.get("DSP", math.nan), \
+                                    resource.get("BRAM18K", math.nan), resource.get("URAM", math.nan))
+        else:
+            value = self.VALUE.pack(reward, math.nan, math.nan, math.nan)
+        fcntl.flock(self.fd, fcntl.LOCK_EX)
+        try:
+            for off in self.slots(key):
+                slot_key = self.buf[off: off + self.KEY_SIZE]
+                if slot_key == key:
+                    return
+                if not any(slot_key):
+                    self.buf[off + self.KEY_SIZE: off + self.RECORD_SIZE] = value
+                    self.buf[off: off + self.KEY_SIZE] = key
+                    return
+            # The probing window is full, drop the record
+            self.drops += 1
+        finally:
+            fcntl.flock(self.fd, fcntl.LOCK_UN)
+
+eval_cache_config = {"path": None, "capacity": 1 << 20}
+eval_caches = {}
+
+def set_eval_cache(path, capacity=1 << 20):
+    """ Enable the persistent evaluation cache for all the tuners.
+    """
+    eval_cache_config["path"] = path
+    eval_cache_config["capacity"] = capacity
+
+def get_eval_cache():
+    """ Return the evaluation cache mapped in the current process.
+    """
+    if not eval_cache_config["path"]:
+        return None
+    pid = os.getpid()
+    if pid not in eval_caches:
+        eval_caches[pid] = EvalCache(eval_cache_config["path"], eval_cache_config["capacity"])
+    return eval_caches[pid]
+
+checkpoint_config = {"path": None, "interval": 300, "resume": False}
+
+def set_checkpoint(path, interval=300, resume=False):
+    """ Enable checkpointing the tuner states to the directory "path" every 
+    "interval" seconds. If "resume" is set, the tuners restart from the checkpoints.
+    """
+    os.makedirs(path, exist_ok=True)
+    checkpoint_config["path"] = path
+    checkpoint_config["interval"] = interval
+    checkpoint_config["resume"] = resume
+
+def checkpoint_file(tag):
+    return f'{checkpoint_config["path"]}/{hashlib.sha1(tag.encode()).hexdigest()[:20]}.ckpt'
+
+def checkpoint_due(last_save):
+    """ Return True if checkpointing is enabled and the interval has elapsed.
+    """
+    return checkpoint_config["path"] != None and time.time() - last_save >= checkpoint_config["interval"]
+
+def save_checkpoint(tag, state):
+    """ Dump the state together with the RNG states.
+    The file is replaced atomically so that a preempted job never leaves a 
+    corrupted checkpoint behind.
+    """
+    if not checkpoint_config["path"]:
+        return
+    state = dict(state, tag=tag, random=random.getstate(), np_random=np.random.get_state())
+    path = checkpoint_file(tag)
+    with open(f'{path}.{os.getpid()}.tmp', 'wb') as f:
+        pickle.dump(state, f, protocol=pickle.HIGHEST_PROTOCOL)
+    os.replace(f'{path}.{os.getpid()}.tmp', path)
+
+def load_checkpoint(tag):
+    """ Load the state and restore the RNG states. Return None if there is no 
+    checkpoint to resume from.
+    """
+    if not checkpoint_config["path"] or not checkpoint_config["resume"]:
+        return None
+    path = checkpoint_file(tag)
+    if not os.path.exists(path):
+        return None
+    with open(path, 'rb') as f:
+        state = pickle.load(f)
+    if state["tag"] != tag:
+        return None
+    random.setstate(state["random"])
+    np.random.set_state(state["np_random"])
+    return state
+
 class PerfCounter(object):
     def __init__(self, logger=None):
         self.logger = logger
@@ -107,6 +472,11 @@ class PerfCounter(object):
         self.counters[name]['elapsed'] += (now - self.counters[name]['start'])
         self.counters[name]['start'] = now
 
+    def restore_counter(self, name, elapsed):
+        """ Restart the counter with the elapsed time loaded from a checkpoint.
+        """
+        self.counters[name] = {'start': time.perf_counter(), 'elapsed': elapsed}
+
     def get_counter(self, name):
         if name not in self.counters:
             raise RuntimeError(f"Counter {name} is not defined")
@@ -23,6 +23,7 @@ import logging
 import functools
 import shutil
 import datetime
+import hashlib
 from pathlib import Path
 
 import optimizer_prune as opt_prune
@@ -189,6 +190,8 @@ def multi_process(loops, func, config):
     config['logger'] = None
     n_designs = config['monitor']['n_designs']
     config['monitor']['n_designs'] = 0
+    n_stage_cache_hits = config['monitor']['n_stage_cache_hits']
+    config['monitor']['n_stage_cache_hits'] = 0
 
     # Execute the function
     results = pool.starmap(func, [(loop_chunks[i], copy.deepcopy(config),
@@ -196,7 +199,9 @@ def multi_process(loops, func, config):
     # Aggregate the monitor information
     for result in results:
         n_designs += result['monitor']['n_designs']
+        n_stage_cache_hits += result['monitor']['n_stage_cache_hits']
     config['monitor']['n_designs'] = n_designs
+    config['monitor']['n_stage_cache_hits'] = n_stage_cache_hits
 
     if config['mode'] == 'search':
         # Aggregate the results
@@ -338,13 +343,116 @@ def execute_autosa_cmd(config):
         if float(elapsed_time) / 60 > config['setting']['search']['time_out']:
             return -1
 
+    # Look up the stage cache
+    if config['stage_cache']:
+        entry = f'{config["stage_cache"]}/{stage_cache_key(config)}'
+        if os.path.exists(f'{entry}/ret'):
+            with open(f'{entry}/ret') as f:
+                ret = int(f.read())
+            if ret == 0:
+                shutil.rmtree(f'{config["work_dir"]}/output', ignore_errors=True)
+                shutil.copytree(f'{entry}/output', f'{config["work_dir"]}/output')
+                config['monitor']['n_stage_cache_hits'] += 1
+                return ret
+            # Failed runs are not reused, as they may be caused by time-outs
+            # or killed processes. Drop the entry left by the older versions.
+            shutil.rmtree(entry, ignore_errors=True)
+
     cmd = ' '.join(config['cmds'])
     #config['logger'].info(f'Execute CMD: {cmd}')
     config['logger'].debug(f'Execute CMD: {cmd}')
     p = subprocess.Popen(cmd, shell=True, stdout=config['stdout'])
     ret = p.wait()
+
+    if config['stage_cache'] and ret == 0:
+        save_stage_cache(config, entry, ret)
     return ret
 
+# Digests of the files hashed into the stage cache keys, indexed by
+# (path, mtime, size) to avoid re-reading the AutoSA binary at every stage
+file_digests = {}
+
+def file_digest(path):
+    """ Return the SHA-1 digest of the file contents.
+
+    Parameters
+    ----------
+    path: str
+        Path to the file.
+    """
+    st = os.stat(path)
+    key = (os.path.realpath(path), st.st_mtime_ns, st.st_size)
+    if key not in file_digests:
+        h = hashlib.sha1()
+        with open(path, 'rb') as f:
+            for chunk in iter(lambda: f.read(1 << 20), b''):
+                h.update(chunk)
+        file_digests[key] = h.hexdigest()
+
+    return file_digests[key]
+
+def stage_cache_key(config):
+    """ Compute the key of the stage cache.
+
+    The AutoSA outputs are determined by the user command, the sa_sizes decided
+    so far, the AutoSA configuration file, the hardware resource file, and the
+    AutoSA binary. The work directory is excluded so that the processes can
+    share the results.
+
+    Parameters
+    ----------
+    config: dict
+        Global configuration.
+    """
+    h = hashlib.sha1()
+    h.update(config['cmds'][0].encode())
+    h.update(config['cmds'][3].encode())
+    with open(f'{config["work_dir"]}/autosa_config.json', 'rb') as f:
+        h.update(f.read())
+    # The command starts with the ./autosa wrapper script, which runs the
+    # compiler ./src/autosa (or the libtool executable under ./src/.libs).
+    exe = config['cmds'][0].split()[0]
+    exe_dir = os.path.dirname(exe)
+    for path in [exe, os.path.join(exe_dir, 'src', 'autosa'), \
+                 os.path.join(exe_dir, 'src', '.libs', 'autosa')]:
+        if os.path.isfile(path):
+            h.update(file_digest(path).encode())
+    m = re.search(r'--(?:autosa-)?hw-info=(\S+)', config['cmds'][0])
+    if m and os.path.isfile(m.group(1)):
+        h.update(file_digest(m.group(1)).encode())
+
+    return h.hexdigest()
+
+def save_stage_cache(config, entry, ret):
+    """ Store the AutoSA outputs of the current stage to the stage cache.
+
+    Only successful runs are stored, so that the failed ones are retried.
+    The entry is first built in a private directory and then renamed, so that
+    concurrent processes never observe a partial entry.
+
+    Parameters
+    ----------
+    config: dict
+        Global configuration.
+    entry: str
+        Path to the cache entry.
+    ret: int
+        The command return code.
+    """
+    if ret != 0 or os.path.exists(entry):
+        return
+    tmp_entry = f'{entry}.{os.getpid()}.tmp'
+    shutil.rmtree(tmp_entry, ignore_errors=True)
+    os.makedirs(tmp_entry)
+    shutil.copytree(f'{config["work_dir"]}/output', f'{tmp_entry}/output')
+    with open(f'{tmp_entry}/ret', 'w') as f:
+        f.write(str(ret))
+    try:
+        os.rename(tmp_entry, entry)
+    except OSError:
+        # Another process has stored the same entry
+        shutil.rmtree(tmp_entry, ignore_errors=True)
+
 def execute_sys_cmd(cmd, config):
     """ Execute the system command.
 
@@ -413,6 +521,31 @@ def clear_design_files(config):
     execute_sys_cmd(f'rm {config["work_dir"]}/output/resource_est/*', config)
     execute_sys_cmd(f'rm {config["work_dir"]}/output/src/*', config)
 
+def load_native_resource_estimate(design_dir, target):
+    """ Load the resource usage estimated by AutoSA.
+
+    AutoSA estimates the DSP, BRAM18K, and URAM usage of the design and dumps
+    it to "resource_est/design_resource.json". The estimate replaces the
+    resource models if only these resources are targeted.
+    Return None if the estimate can't be used.
+
+    Parameters
+    ----------
+    design_dir: str
+        Design directory.
+    target: list
+        A list containing the hw resource target to predict.
+    """
+    path = f'{design_dir}/resource_est/design_resource.json'
+    if not set(target) <= {'DSP', 'BRAM18K', 'URAM'} or not os.path.isfile(path):
+        return None
+    with open(path, 'r') as f:
+        est = json.load(f)
+    res = {'FF': 0, 'LUT': 0, 'BRAM18K': 0, 'URAM': 0, 'DSP': 0}
+    for r in target:
+        res[r] = est[r]
+    return res
+
 def explore_design(config):
     """ Explore the final design.
 
@@ -461,15 +594,17 @@ def explore_design(config):
 
         # Predict the resource usage
         #start_time = time.perf_counter()
-        design_info = res_model.extract_design_info(design_dir, 0)
-        modules, fifos, df = res_model.convert_design_infos_to_df([design_info])
-        kernel_id = design_info['kernel_id']
-        # Resource model path
-        res_model_path = f'{tmp_dir}/optimizer/training/resource_models/kernel{kernel_id}'
-        res = res_model.predict_design_resource_usage(
-            df, modules, fifos, design_info,
-            res_model_path,
-            config['setting']['search']['resource_target'])
+        res = load_native_resource_estimate(design_dir, config['setting']['search']['resource_target'])
+        if res is None:
+            design_info = res_model.extract_design_info(design_dir, 0)
+            modules, fifos, df = res_model.convert_design_infos_to_df([design_info])
+            kernel_id = design_info['kernel_id']
+            # Resource model path
+            res_model_path = f'{tmp_dir}/optimizer/training/resource_models/kernel{kernel_id}'
+            res = res_model.predict_design_resource_usage(
+                df, modules, fifos, design_info,
+                res_model_path,
+                config['setting']['search']['resource_target'])
         cur_design['resource'] = res
 
         if not res_model.resource_valid(res, config['hw_info'], \
@@ -888,11 +1023,76 @@ def explore_array_part(config):
             explore_latency_hiding(config)
 
 
+def explore_space_time_kernels(config, n_kernel):
+    """ Iterate through all the kernels generated by the space-time transformation.
+
+    Parameters
+    ----------
+    config: dict
+        Global configuration.
+    n_kernel: int
+        The number of kernels.
+    """
+    #for kernel_id in [0]:
+    for kernel_id in range(n_kernel):
+        config['logger'].info(f'Search kernel {kernel_id}...')
+        sa_sizes = config['sa_sizes'].copy()
+        config['sa_sizes'].append(f'kernel[]->space_time[{kernel_id}]')
+        config['cmds'][3] = generate_sa_sizes_cmd(config['sa_sizes'])
+        ret = execute_autosa_cmd(config)
+        if ret != 0:
+            config['logger'].error(f'CMD failed with error code {ret}')
+            config['sa_sizes'] = sa_sizes
+            continue
+        explore_array_part(config)
+        config['sa_sizes'] = sa_sizes
+
+def explore_rar_dep(config, rar_dep):
+    """ Explore the RAR dependence choices of the array references.
+
+    AutoSA picks one reuse vector for each array reference with multiple legal
+    RAR dependences, which determines the data reuse directions of the array.
+    We iterate through all the combinations of the non-default choices, and
+    explore the kernels generated by the space-time transformation for each
+    of them. The choices are passed to AutoSA through "--select-rar-dep".
+
+    Parameters
+    ----------
+    config: dict
+        Global configuration.
+    rar_dep: dict
+        The RAR dependence choices {ref_name: {"n_candidates": int, "default": int}}.
+    """
+    cmd = config['cmds'][0]
+    refs = sorted(rar_dep)
+    defaults = tuple([rar_dep[ref]['default'] for ref in refs])
+    for choices in itertools.product(*[range(rar_dep[ref]['n_candidates']) for ref in refs]):
+        if choices == defaults:
+            # Explored already
+            continue
+        select = ';'.join([f'kernel[]->{ref}[{choice}]' for ref, choice in zip(refs, choices)])
+        config['logger'].info(f'Search RAR dependences {select}...')
+        config['cmds'][0] = f'{cmd} --autosa-select-rar-dep="{{{select}}}"'
+        config['cmds'][3] = generate_sa_sizes_cmd(config['sa_sizes'])
+        ret = execute_autosa_cmd(config)
+        if ret != 0:
+            config['logger'].error(f'CMD failed with error code {ret}')
+            continue
+        with open(f'{config["work_dir"]}/output/tuning.json') as f:
+            tuning = json.load(f)
+        if 'space_time' not in tuning:
+            explore_array_part(config)
+        else:
+            explore_space_time_kernels(config, tuning['space_time']['n_kernel'])
+    config['cmds'][0] = cmd
+
 def explore_space_time(config):
     """ Explore the stage of space-time transformation.
 
     If this stage is set in Manual mode, we will load the tuning info
     and iterate through all possible kernels to proceed.
+    The RAR dependence choices reported in the tuning info are explored
+    as well, unless users have selected them with "--select-rar-dep".
     Otherwise, AutoSA automatically selects one kernel to proceed.
     We will directly jump to the next stage: array partitioning.
 
@@ -910,22 +1110,10 @@ def explore_space_time(config):
             # Users have assigned the space-time options, we will skip this stage
             explore_array_part(config)
         else:
-            n_kernel = tuning['space_time']['n_kernel']
-
             # Iterate through different kernels
-            #for kernel_id in [0]:
-            for kernel_id in range(n_kernel):
-                config['logger'].info(f'Search kernel {kernel_id}...')
-                sa_sizes = config['sa_sizes'].copy()
-                config['sa_sizes'].append(f'kernel[]->space_time[{kernel_id}]')
-                config['cmds'][3] = generate_sa_sizes_cmd(config['sa_sizes'])
-                ret = execute_autosa_cmd(config)
-                if ret != 0:
-                    config['logger'].error(f'CMD failed with error code {ret}')
-                    config['sa_sizes'] = sa_sizes
-                    continue
-                explore_array_part(config)
-                config['sa_sizes'] = sa_sizes
+            explore_space_time_kernels(config, tuning['space_time']['n_kernel'])
+            if 'rar_dep' in tuning and config['cmds'][0].find('select-rar-dep') == -1:
+                explore_rar_dep(config, tuning['rar_dep'])
     else:
         explore_array_part(config)
 
@@ -1009,6 +1197,7 @@ def generate_train_samples(config):
         # Collect enough training samples
         explore_design_space(config)
     config['logger'].info(f'{config["monitor"]["n_designs"]} designs are generated.')
+    config['logger'].info(f'{config["monitor"]["n_stage_cache_hits"]} AutoSA runs are reused from the stage cache.')
 
 @timer
 def synth_train_samples(config):
@@ -1315,6 +1504,7 @@ def search_xilinx(config):
     log_path = f'{tmp_dir}/optimizer/search/DSE.log'
     config['logger'].info(f'Saving the DSE results to: {log_path}')
     save_search_log(config['search_results']['records'], log_path)
+    config['logger'].info(f'{config["monitor"]["n_stage_cache_hits"]} AutoSA runs are reused from the stage cache.')
 
     return
 
@@ -1381,8 +1571,9 @@ def init_monitor():
     monitor: dict
         "n_designs": number of designs that are examined
         "time_out_start": the starting time for time-out counter
+        "n_stage_cache_hits": number of AutoSA runs skipped by the stage cache
     """
-    monitor = {"n_designs": 0, "time_out_start": -1}
+    monitor = {"n_designs": 0, "time_out_start": -1, "n_stage_cache_hits": 0}
 
     return monitor
 
@@ -1523,7 +1714,7 @@ def merge_search_results(results, metric, n_record, hw_info):
     else:
         raise NotImplementedError(f'Merge results for metric {metric} is not supported.')
 
-def init_config(setting, verbose, hw_info, cmd, training, search, tmp_dir):
+def init_config(setting, verbose, hw_info, cmd, training, search, tmp_dir, stage_cache=1):
     """ Init AutoSA Optimizer global configuration.
 
     Init the global configuration used in Optimizer.
@@ -1536,6 +1727,8 @@ def init_config(setting, verbose, hw_info, cmd, training, search, tmp_dir):
         Print verbose level.
     tmp_dir: str
         Path to the temporary files.
+    stage_cache: boolean
+        Enable the stage cache.
 
     Note
     ----
@@ -1573,6 +1766,9 @@ def init_config(setting, verbose, hw_info, cmd, training, search, tmp_dir):
       monitor: dict
         A dictionary storing the monitoring information of the DSE
           "n_designs": number of designs that are examined
+      stage_cache: str
+        Path to the stage cache that stores the AutoSA outputs of each
+        sa_sizes prefix, None if disabled.
 
     Returns
     -------
@@ -1595,11 +1791,19 @@ def init_config(setting, verbose, hw_info, cmd, training, search, tmp_dir):
     with open(hw_info) as f:
         config['hw_info'] = json.load(f)
     config['cmds'] = [cmd]
+    if not training and cmd.find('hw-info') == -1:
+        # Record the designs exceeding the FPGA resources inside AutoSA.
+        # The training mode samples designs regardless of the resources.
+        config['cmds'][0] += f' --autosa-hw-info={hw_info}'
     config['cmds'].append(
         f'--autosa-config={config["work_dir"]}/autosa_config.json')
     config['cmds'].append(f'--autosa-output-dir={config["work_dir"]}/output')
     config['cmds'].append('')
     config['sa_sizes'] = []
+    config['stage_cache'] = None
+    if stage_cache:
+        config['stage_cache'] = f'{tmp_dir}/optimizer/stage_cache'
+        Path(config['stage_cache']).mkdir(exist_ok=True)
     # Look up if sa_sizes are pre-set in the cmd
     if config['cmds'][0].find('sa-sizes') != -1:
         m = re.search(r'--sa-sizes="{(.+?)}"', config['cmds'][0])
@@ -1627,7 +1831,7 @@ def init_config(setting, verbose, hw_info, cmd, training, search, tmp_dir):
     return config
 
 
-def xilinx_run(cmd, hw_info, setting, training, search, verbose, tmp_dir):
+def xilinx_run(cmd, hw_info, setting, training, search, verbose, tmp_dir, stage_cache=1):
     """ Design space exploration on Xilinx platform.
 
     The following four stages are explored in the DSE:
@@ -1683,6 +1887,9 @@ def xilinx_run(cmd, hw_info, setting, training, search, verbose, tmp_dir):
         Print verbose information.
     tmp_dir: str
         Path to the folder that stores the temp files.
+    stage_cache: boolean
+        Reuse the AutoSA outputs of the sa_sizes prefixes compiled before.
+        The cache is kept in the folder optimizer/stage_cache across runs.
     """
 
     if not os.path.exists(f'{tmp_dir}/optimizer'):
@@ -1690,7 +1897,7 @@ def xilinx_run(cmd, hw_info, setting, training, search, verbose, tmp_dir):
 
     # Init logger and optimizer config
     logger = init_logger(training, search, verbose, tmp_dir)
-    config = init_config(setting, verbose, hw_info, cmd, training, search, tmp_dir)
+    config = init_config(setting, verbose, hw_info, cmd, training, search, tmp_dir, stage_cache)
     config['logger'] = logger
     # Init monitor
     config['monitor'] = init_monitor()
@@ -1762,6 +1969,10 @@ if __name__ == "__main__":
         required=False,
         default='./autosa.tmp',
         help='temporary file directory')
+    parser.add_argument(
+        '--no-stage-cache',
+        action='store_true',
+        help='disable reusing the AutoSA outputs of the explored stages')
 
     args = parser.parse_args()
 
@@ -1779,4 +1990,5 @@ if __name__ == "__main__":
             args.training,
             args.search,
             args.verbose,
-            args.tmp_dir)
+            args.tmp_dir,
+            not args.no_stage_cache)
@@ -674,7 +674,7 @@ def train(df, modules, fifos, design_infos, work_dir, logger):
     logger.info('URAM Mean Absoulate Percentage Error (Arith. Mean): %.2f%%' %(mean(URAM_design_mape)))    
 
 def predict_design_resource_usage(df, modules, fifos, design_info, prj_dir, \
-    target=['FF', 'LUT', 'DSP', 'BRAM18K', 'URAM']):
+    target=['FF', 'LUT', 'DSP', 'BRAM18K', 'URAM'], module_resource=None):
     """ Predict the resource usage for a single design on Xilinx platforms
 
     Parameters
@@ -691,6 +691,9 @@ def predict_design_resource_usage(df, modules, fifos, design_info, prj_dir, \
         Directory to the resource models.    
     target: list
         Resource types to predict.
+    module_resource: dict
+        If not None, it is filled with the predicted resource usage of a single
+        instance of each module and FIFO.
     """
     resource = {'FF': 0, 'LUT': 0, 'DSP': 0, 'BRAM18K': 0, 'URAM': 0}    
     resource_all = {}
@@ -787,6 +790,8 @@ def predict_design_resource_usage(df, modules, fifos, design_info, prj_dir, \
 
     #pp = pprint.PrettyPrinter(indent=4)
     #pp.pprint(resource_all)
+    if module_resource is not None:
+        module_resource.update(resource_all)
 
     # Aggregate the resource
     for inst in resource_all:
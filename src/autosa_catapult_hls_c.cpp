@@ -29,7 +29,8 @@ struct print_hw_module_data
 /* Open the host .cpp file and the kernel .h and .cpp files for writing.
  * Add the necessary includes.
  */
-static void hls_open_files(struct hls_info *info, const char *input)
+static void hls_open_files(struct hls_info *info, const char *input,
+                           struct ppcg_options *options)
 {
   char name[PATH_MAX];
   char dir[PATH_MAX];
@@ -138,6 +139,9 @@ static void hls_open_files(struct hls_info *info, const char *input)
   fprintf(info->kernel_h, "#include <ac_float.h>\n");
   fprintf(info->kernel_h, "#include <ac_std_float.h>\n");
   fprintf(info->kernel_h, "#include <ac_math.h>\n");
+  if (options->autosa->fast_drain_merge)
+    /* memcpy is used to merge the drained data. */
+    fprintf(info->kernel_h, "#include <cstring>\n");
   fprintf(info->kernel_h, "\n");
 
   fprintf(info->kernel_h, "#define min(x,y) ((x < y) ? x : y)\n");
@@ -2146,6 +2150,7 @@ static __isl_give isl_printer *autosa_print_host_code(__isl_take isl_printer *p,
   /* Print the macros for sparse data structure */
   if (prog->scop->options->autosa->block_sparse) {
     print_sparse_macros(top->kernel, hls);
+    print_sparse_pack_funcs(top->kernel, hls);
   }
 
   /* Print the helper functions in the program. */
@@ -3056,7 +3061,7 @@ int generate_autosa_catapult_hls_c(isl_ctx *ctx, struct ppcg_options *options,
   hls.ctx = ctx;
   hls.output_dir = options->autosa->output_dir;
   hls.hcl = options->autosa->hcl;
-  hls_open_files(&hls, input);
+  hls_open_files(&hls, input, options);
 
   r = generate_sa(ctx, input, hls.host_c, options, &print_hw, &hls);
 
@@ -1,6 +1,7 @@
 #include <isl/aff.h>
 
 #include <barvinok/isl.h>
+#include <algorithm>
 
 #include "autosa_codegen.h"
 #include "autosa_utils.h"
@@ -2441,6 +2442,103 @@ OUTER_INSERT_STMT:
   return new_sched;
 }
 
+/* Estimate the number of cycles to execute the subtree rooted at "node", 
+ * assuming each loop iteration takes one cycle.
+ */
+static long estimate_subtree_cycles(__isl_keep isl_schedule_node *node)
+{
+  long cycles = 0;
+  int n;
+
+  if (isl_schedule_node_get_type(node) == isl_schedule_node_leaf)
+    return 1;
+
+  /* The children of the sequence/set nodes are executed one after another. */
+  n = isl_schedule_node_n_children(node);
+  for (int i = 0; i < n; i++)
+  {
+    isl_schedule_node *child = isl_schedule_node_get_child(node, i);
+    cycles += estimate_subtree_cycles(child);
+    isl_schedule_node_free(child);
+  }
+  if (isl_schedule_node_get_type(node) == isl_schedule_node_band)
+  {
+    int *ubs = extract_band_upper_bounds(node);
+    for (int i = 0; i < isl_schedule_node_band_n_member(node); i++)
+      cycles *= ubs[i];
+    free(ubs);
+  }
+
+  return cycles;
+}
+
+/* Decide whether to double buffer the I/O "module" at io_L"io_level" 
+ * of "group".
+ * Without double buffering, the PEs wait for the I/O module to fill the
+ * buffer for each array partition tile. 
+ * The transfer latency is the number of packed elements of the buffers 
+ * in the daisy chain of I/O modules at this level. 
+ * The compute latency is the number of cycles of the PE loops inside 
+ * the array partition tile.
+ * The double buffer is assigned if it hides at least 10% of the 
+ * latency of a tile, and the extra buffers fit in the BRAM18K budget left.
+ */
+static int io_module_double_buffer_assign(struct autosa_hw_module *module,
+                                          struct autosa_array_ref_group *group, struct autosa_kernel *kernel,
+                                          struct autosa_gen *gen, int io_level)
+{
+  struct autosa_io_buffer *buffer = group->io_buffers[io_level - 1];
+  isl_schedule_node *node;
+  long n_lane, n_chain, elems = 1;
+  long transfer, compute, bram;
+  int double_buffer;
+  cJSON *report, *info;
+
+  if (!buffer->tile)
+    return 1;
+
+  n_lane = buffer->n_lane > 0 ? buffer->n_lane : 1;
+  for (int i = 0; i < buffer->tile->n; i++)
+    elems *= isl_val_get_num_si(buffer->tile->bound[i].size);
+  n_chain = autosa_io_module_instance_cnt(kernel, group, io_level);
+  if (io_level < group->io_level)
+    n_chain /= autosa_io_module_instance_cnt(kernel, group, io_level + 1);
+  transfer = (elems + n_lane - 1) / n_lane * (n_chain > 0 ? n_chain : 1);
+
+  node = isl_schedule_get_root(kernel->schedule);
+  node = autosa_tree_move_down_to_pe(node, kernel->core);
+  compute = estimate_subtree_cycles(node) / (kernel->simd_w > 0 ? kernel->simd_w : 1);
+  isl_schedule_node_free(node);
+
+  bram = autosa_io_buffer_bram18k(kernel, group, io_level);
+  double_buffer = std::min(transfer, compute) * 9 >= std::max(transfer, compute);
+  if (double_buffer && gen->io_bram18k_left >= 0)
+  {
+    if (bram > gen->io_bram18k_left)
+      double_buffer = 0;
+    else
+      gen->io_bram18k_left -= bram;
+  }
+
+  report = cJSON_GetObjectItemCaseSensitive(gen->io_buffer_report, "double_buffer");
+  if (!report)
+  {
+    report = cJSON_CreateObject();
+    cJSON_AddItemToObject(gen->io_buffer_report, "double_buffer", report);
+  }
+  info = cJSON_CreateObject();
+  cJSON_AddNumberToObject(info, "enable", double_buffer);
+  cJSON_AddNumberToObject(info, "transfer_cycles", transfer);
+  cJSON_AddNumberToObject(info, "compute_cycles", compute);
+  cJSON_AddNumberToObject(info, "BRAM18K", bram);
+  cJSON_AddItemToObject(report, module->name, info);
+  if (gen->options->autosa->verbose)
+    printf("[AutoSA] Double buffer of %s: %s (transfer: %ld, compute: %ld, BRAM18K: %ld)\n",
+           module->name, double_buffer ? "enabled" : "disabled", transfer, compute, bram);
+
+  return double_buffer;
+}
+
 /* We will generate five seperate schedules for this type of I/O module.
  * Schedule 1: Outer loops contains two marks for inter_transfer 
  *             and intra_transfer modules
@@ -2472,9 +2570,13 @@ static __isl_give struct autosa_hw_module *generate_filter_buffer_io_module(
     if (!double_buffer_assignment) {
       /* Use the default strategy:
        * Set all the modules to double buffer except the drain module.       
+       * In the automatic assignment, decide by the latency and BRAM cost.
        */      
       if (group->group_type == AUTOSA_DRAIN_GROUP) {
         module->double_buffer = 0;
+      } else if (gen->options->autosa->auto_buffer_assign) {
+        module->double_buffer = io_module_double_buffer_assign(
+            module, group, kernel, gen, io_level);
       } else {
         module->double_buffer = 1;
       }      
@@ -3662,7 +3764,7 @@ static __isl_give struct autosa_hw_module **sa_io_module_gen(
       else
         is_buffer = 0;
 
-      if (gen->options->autosa->two_level_buffer)
+      if (group->two_level_buffer)
       {
         /* When two-level buffering is enabled, 
          * we will implement a second-level buffe at the outermost I/O module.
@@ -3756,7 +3858,7 @@ static __isl_give struct autosa_hw_module **sa_io_module_gen(
       else
         is_buffer = 0;
 
-      if (gen->options->autosa->two_level_buffer)
+      if (group->two_level_buffer)
       {
         /* When two-level buffering is enabled, 
          * we will implement a second-level buffer at the outermost I/O module.
@@ -4565,6 +4667,7 @@ static __isl_give isl_schedule_node *insert_context(struct autosa_kernel *kernel
  * find the lcm of all the data packing factors to set as the array partitioning
  * factor for the local buffer so that all I/O groups should be able to 
  * access the packed elements without any bank conflict.
+ * Accumulators are promoted to registers if possible (see autosa_pe_acc_reg).
  */
 static void create_pe_module_var(isl_ctx *ctx,
                                  struct autosa_kernel *kernel,
@@ -4625,6 +4728,20 @@ static void create_pe_module_var(isl_ctx *ctx,
       var->size = isl_vec_set_element_val(var->size, i, size);
     }
   }
+
+  long n_ele = 1;
+  for (int i = 0; i < isl_vec_size(var->size); i++)
+  {
+    isl_val *v = isl_vec_get_element_val(var->size, i);
+    n_ele *= isl_val_get_num_si(v);
+    isl_val_free(v);
+  }
+  var->acc_reg = autosa_pe_acc_reg(kernel, group, n_ele);
+  if (var->acc_reg) {
+    var->acc_dist = autosa_pe_acc_dep_dis(kernel, group);
+    printf("[AutoSA] Promote the accumulator %s to registers (dependence distance: %d).\n", 
+           var->name, var->acc_dist);
+  }
 }
 
 /* Create the local buffer variables inside the PE module. */
@@ -9032,6 +9149,40 @@ static __isl_give isl_ast_node *create_io_leaf(struct autosa_kernel *kernel,
   return isl_ast_node_set_annotation(node, id);
 }
 
+/* Examine if "ma" only uses the innermost loop iterator in the last array
+ * index, with a unit coefficient.
+ */
+static isl_stat drain_merge_piece_is_contiguous(__isl_take isl_set *set,
+                                                __isl_take isl_multi_aff *ma, void *user)
+{
+  isl_bool *contiguous = (isl_bool *)user;
+  int n_in, n_out;
+
+  n_in = isl_multi_aff_dim(ma, isl_dim_in);
+  n_out = isl_multi_aff_dim(ma, isl_dim_out);
+  if (n_in == 0 || n_out == 0)
+    *contiguous = isl_bool_false;
+  for (int i = 0; i < n_out && *contiguous == isl_bool_true; i++)
+  {
+    isl_aff *aff = isl_multi_aff_get_aff(ma, i);
+    if (i == n_out - 1)
+    {
+      isl_val *val = isl_aff_get_coefficient_val(aff, isl_dim_in, n_in - 1);
+      if (!isl_val_is_one(val))
+        *contiguous = isl_bool_false;
+      isl_val_free(val);
+      aff = isl_aff_set_coefficient_si(aff, isl_dim_in, n_in - 1, 0);
+    }
+    if (isl_aff_involves_dims(aff, isl_dim_in, n_in - 1, 1) != isl_bool_false)
+      *contiguous = isl_bool_false;
+    isl_aff_free(aff);
+  }
+
+  isl_set_free(set);
+  isl_multi_aff_free(ma);
+  return isl_stat_ok;
+}
+
 static __isl_give isl_ast_node *create_drain_merge_leaf(struct autosa_kernel *kernel,
                                                         struct autosa_drain_merge_func *func, __isl_take isl_ast_node *node,
                                                         __isl_keep isl_ast_build *build)
@@ -9066,9 +9217,30 @@ static __isl_give isl_ast_node *create_drain_merge_leaf(struct autosa_kernel *ke
   /* L -> A */
   pma2 = isl_pw_multi_aff_pullback_pw_multi_aff(pma2,
                                                 isl_pw_multi_aff_copy(pma));
-  expr = isl_ast_build_access_from_pw_multi_aff(build, pma2);
   isl_pw_multi_aff_free(pma);
 
+  /* Record the innermost loop if it walks the last array dimension with the
+   * unit stride. The host merges the elements along this loop with memcpy.
+   */
+  if (kernel->options->autosa->fast_drain_merge)
+  {
+    isl_bool contiguous = isl_bool_true;
+    if (isl_pw_multi_aff_foreach_piece(pma2, &drain_merge_piece_is_contiguous,
+                                       &contiguous) < 0)
+      contiguous = isl_bool_false;
+    if (contiguous == isl_bool_true)
+    {
+      int n;
+      space = isl_ast_build_get_schedule_space(build);
+      n = isl_space_dim(space, isl_dim_set);
+      id = isl_space_get_dim_id(space, isl_dim_set, n - 1);
+      stmt->u.dm.contiguous_iter = strdup(isl_id_get_name(id));
+      isl_id_free(id);
+      isl_space_free(space);
+    }
+  }
+  expr = isl_ast_build_access_from_pw_multi_aff(build, pma2);
+
   /* Linearize the index. */
   group = func->group;
   expr = autosa_local_array_info_linearize_index(group->local_array, expr);
@@ -10214,6 +10386,11 @@ static isl_bool loop_infinitize_check(__isl_keep isl_ast_node *node, void *user)
 /* Try to apply the loop infinitization optimization.
  * This optimization is useful for Intel devices since we can remove some 
  * for loops with a simple while (1) loop to reduce the loop control overheads.
+ * For TAPA, the infinitized modules are further invoked as detached tasks 
+ * that the top task doesn't wait for. Modules that take host loop iterators 
+ * are skipped for TAPA as the iterators are updated by the host between tiles.
+ * Xilinx HLS modules keep the block-level control and are not infinitized, 
+ * as a module running a while (1) loop would never assert ap_done.
  * We will examine the outermost for loop band from outside to inside.
  * For each for loop, we examine if the loop iterator appears in any AST
  * expression below. If not, this loop will be marked to be infinitized later.
@@ -10226,21 +10403,34 @@ static isl_bool loop_infinitize_check(__isl_keep isl_ast_node *node, void *user)
  */
 static void loop_infinitization_optimize(struct autosa_hw_module *module)
 {
+  int target = module->options->target;
+  int free_running = 1;
+
   if (module->double_buffer || module->to_mem)
     return;
+  if (target == AUTOSA_TARGET_TAPA_CPP)
+  {
+    if (module->space && isl_space_dim(module->space, isl_dim_set) > 0)
+      return;
+  }
 
   if (module->device_tree)
   {
     isl_ast_node *node = module->device_tree;
     struct loop_infinitize_check_data data = {isl_bool_true, module, isl_bool_false};
     isl_ast_node_foreach_descendant_top_down(node, &loop_infinitize_check, &data);
+    free_running = free_running && data.found;
   }
   if (module->boundary_tree)
   {
     isl_ast_node *node = module->boundary_tree;
     struct loop_infinitize_check_data data = {isl_bool_true, module, isl_bool_false};
     isl_ast_node_foreach_descendant_top_down(node, &loop_infinitize_check, &data);
+    free_running = free_running && data.found;
   }
+
+  if (target == AUTOSA_TARGET_TAPA_CPP)
+    module->free_running = free_running;
 }
 
 /* Mark all for loop as visited.  
@@ -10874,7 +11064,8 @@ isl_stat sa_filter_buffer_io_module_generate_code(struct autosa_gen *gen,
   }
 
   /* Perform loop infinitization optimization. */
-  if (gen->options->target == AUTOSA_TARGET_INTEL_OPENCL &&
+  if ((gen->options->target == AUTOSA_TARGET_INTEL_OPENCL ||
+       gen->options->target == AUTOSA_TARGET_TAPA_CPP) &&
       gen->options->autosa->loop_infinitize)
   {
     loop_infinitization_optimize(module);
@@ -10983,7 +11174,8 @@ isl_stat sa_module_generate_code(struct autosa_gen *gen,
   }
 
   /* Perform loop infinitization optimization. */
-  if (gen->options->target == AUTOSA_TARGET_INTEL_OPENCL &&
+  if ((gen->options->target == AUTOSA_TARGET_INTEL_OPENCL ||
+       gen->options->target == AUTOSA_TARGET_TAPA_CPP) &&
       gen->options->autosa->loop_infinitize)
   {
     loop_infinitization_optimize(module);
@@ -2,6 +2,8 @@
 
 #include <isl/ilp.h>
 
+#include <algorithm>
+
 #include "autosa_schedule_tree.h"
 #include "autosa_utils.h"
 #include "autosa_print.h"
@@ -491,15 +493,55 @@ isl_bool can_tile(__isl_keep isl_map *access,
   return valid;
 }
 
+/* Internal data struct for check_contraction.
+ * If "live_range" is set, the loops carrying the RAW/RAR dependences "deps"
+ * of the array do not prevent the contraction. Instead, the tile is computed 
+ * above the outermost of such loops, where the data stay live, and the node 
+ * at this level is kept in "tile_node".
+ */
 struct check_contraction_data {
   bool legal;
+  bool live_range;
   struct autosa_array_ref_group *group;
   struct autosa_kernel *kernel;
   isl_union_map *prefix;
   isl_union_pw_multi_aff *prefix_upma;
   int depth;
+  std::vector<isl_basic_map *> deps;
+  isl_schedule_node *tile_node;
 };
 
+/* Return the position of the outermost member of "band" that carries any 
+ * of the untagged dependences in "deps", i.e., with a non-zero distance, 
+ * or -1 if there is no such member.
+ * A dependence with non-integer distances is assumed to be carried by the 
+ * first member.
+ */
+static int band_first_carried_member(__isl_keep isl_schedule_node *band,
+                                     const std::vector<isl_basic_map *> &deps)
+{
+  int n = isl_schedule_node_band_n_member(band);
+  int pos = -1;
+
+  for (auto dep : deps)
+  {
+    std::vector<long> dis;
+    if (get_dep_dis_at_node_si(dep, band, dis) < 0)
+      return 0;
+    for (int i = 0; i < n && i < (int)dis.size(); i++)
+    {
+      if (dis[i] != 0)
+      {
+        if (pos == -1 || i < pos)
+          pos = i;
+        break;
+      }
+    }
+  }
+
+  return pos;
+}
+
 struct check_stmt_contain_acc_data {
   struct autosa_kernel *kernel;
   struct autosa_array_ref_group *group;
@@ -584,19 +626,43 @@ static __isl_give isl_schedule_node *check_contraction(
 
     tmp_node2 = isl_schedule_node_copy(tmp_node);
 
-    /* Check if all band nodes above are parallel loops. */    
+    /* Check if all band nodes above are parallel loops. 
+     * In the live range mode, find the outermost loop that carries the 
+     * dependences of the array instead. */    
+    isl_schedule_node *carried = NULL;
+    int carried_pos = -1;
     while (!(autosa_tree_node_is_mark(tmp_node, "pe"))) {    
       if (isl_schedule_node_get_type(tmp_node) == isl_schedule_node_band) {
-        int dim = isl_schedule_node_band_n_member(tmp_node);
-        for (int i = 0; i < dim; i++) {
-          if (!isl_schedule_node_band_member_get_coincident(tmp_node, i)) {
-            data->legal = false;
-            break;
+        if (data->live_range) {
+          int pos = band_first_carried_member(tmp_node, data->deps);
+          if (pos >= 0) {
+            /* Keep the outermost loop that carries dependences. */
+            isl_schedule_node_free(carried);
+            carried = isl_schedule_node_copy(tmp_node);
+            carried_pos = pos;
+          }
+        } else {
+          int dim = isl_schedule_node_band_n_member(tmp_node);
+          for (int i = 0; i < dim; i++) {
+            if (!isl_schedule_node_band_member_get_coincident(tmp_node, i)) {
+              data->legal = false;
+              break;
+            }
           }
         }
       }
       tmp_node = isl_schedule_node_parent(tmp_node);
     }
+    if (carried) {
+      /* The data are live across the iterations of the carried loop,
+       * compute the tiling above it. */
+      isl_schedule_node_free(tmp_node2);
+      tmp_node2 = carried;
+      if (carried_pos > 0) {
+        tmp_node2 = isl_schedule_node_band_split(tmp_node2, carried_pos);
+        tmp_node2 = isl_schedule_node_child(tmp_node2, 0);
+      }
+    }
 
     if (data->prefix == NULL) {
       data->prefix = isl_schedule_node_get_prefix_schedule_union_map(tmp_node2);
@@ -654,6 +720,10 @@ static __isl_give isl_schedule_node *check_contraction(
       data->prefix_upma = isl_schedule_node_get_prefix_schedule_union_pw_multi_aff(tmp_node2);
       data->depth = isl_schedule_node_get_schedule_depth(tmp_node2);
     }    
+    if (data->live_range) {
+      isl_schedule_node_free(data->tile_node);
+      data->tile_node = isl_schedule_node_copy(tmp_node2);
+    }
     isl_schedule_node_free(tmp_node2);
   }
   isl_schedule_node_free(tmp_node);
@@ -693,8 +763,10 @@ static isl_stat compute_group_bounds_core_pe(struct autosa_kernel *kernel,
     struct check_contraction_data contract_data;
     isl_schedule_node *node;        
     contract_data.legal = false;
+    contract_data.live_range = false;
     contract_data.prefix = NULL;
     contract_data.prefix_upma = NULL;
+    contract_data.tile_node = NULL;
 
     /* Create a tile. */
     group->local_tile = autosa_array_tile_create(ctx,
@@ -711,11 +783,19 @@ static isl_stat compute_group_bounds_core_pe(struct autosa_kernel *kernel,
       contract_data.depth = -1;      
       node = isl_schedule_get_root(kernel->schedule);
       node = autosa_tree_move_down_to_pe(node, kernel->core);      
+      autosa_isl_budget_start(ctx, kernel->options);
       node = isl_schedule_node_map_descendant_bottom_up(node, &check_contraction, &contract_data);
+      if (autosa_isl_budget_stop(ctx) || !node || 
+          (contract_data.legal && !contract_data.prefix_upma)) {
+        /* Array contraction is optional, drop it. */
+        autosa_report_degradation(kernel->options, "array contraction",
+                                  "Disable the array contraction.");
+        contract_data.legal = false;
+      }
       isl_schedule_node_free(node);      
     }
     
-    if (contract_data.legal) {
+    if (contract_data.legal && contract_data.prefix) {
       /* We are able to create a register tiling. */      
       acc = isl_map_from_union_map(isl_union_map_apply_domain(isl_union_map_copy(access), 
                                                               isl_union_map_copy(contract_data.prefix)));
@@ -1292,12 +1372,19 @@ static isl_stat autosa_interior_io_eliminate(
  *       s ]
  * where PdT = 0.
  * 
+ * If "dir" has multiple non-zero components (diagonal reuse), s is set to 
+ * the unit vector along the first unit component of "dir" instead, 
+ * with the same sign as that component, 
+ * and the transformed dimensions are shifted to be non-negative.
+ * 
  * This new transformation matrix is applied to the space band.
- * We will return the transformaton matrix in "io_trans_mat" and "io_trans_ma".
+ * We will return the transformaton matrix in "io_trans_mat", the shift in 
+ * "io_trans_cst", and the transformation T * x + shift in "io_trans_ma".
  */
 static __isl_give isl_schedule_node *io_cluster(
     __isl_take isl_schedule_node *node,
-    __isl_keep isl_vec *dir, isl_mat **io_trans_mat, isl_multi_aff **io_trans_ma)
+    __isl_keep isl_vec *dir, isl_mat **io_trans_mat, isl_vec **io_trans_cst,
+    isl_multi_aff **io_trans_ma)
 {
   isl_multi_union_pw_aff *mupa;
   isl_mat *trans_mat, *d_mat, *null_mat;
@@ -1334,10 +1421,37 @@ static __isl_give isl_schedule_node *io_cluster(
       trans_mat = isl_mat_set_element_val(trans_mat, i, j,
                                           isl_mat_get_element_val(null_mat, j, i));
     }
+  /* For the multi-component direction, use the unit vector along the first 
+   * unit component of "dir" as the scheduling vector to keep "T" unimodular.
+   */
+  int n_non_zero = 0;
+  int unit_pos = -1;
+  for (int i = 0; i < isl_vec_size(dir); i++)
+  {
+    isl_val *val = isl_val_abs(isl_vec_get_element_val(dir, i));
+    if (!isl_val_is_zero(val))
+      n_non_zero++;
+    if (unit_pos == -1 && isl_val_is_one(val))
+      unit_pos = i;
+    isl_val_free(val);
+  }
+  if (n_non_zero > 1 && unit_pos == -1)
+  {
+    isl_mat_free(trans_mat);
+    isl_mat_free(null_mat);
+    isl_multi_union_pw_aff_free(mupa);
+    isl_schedule_node_free(node);
+    throw std::runtime_error("[AutoSA] Error: The I/O direction has no unit component.");
+  }
   for (int i = 0; i < isl_vec_size(dir); i++)
   {
-    trans_mat = isl_mat_set_element_val(trans_mat, isl_mat_cols(null_mat), i,
-                                        isl_vec_get_element_val(dir, i));
+    if (n_non_zero > 1 && unit_pos >= 0)
+      trans_mat = isl_mat_set_element_val(trans_mat, isl_mat_cols(null_mat), i,
+                                          i == unit_pos ? isl_vec_get_element_val(dir, i) : 
+                                                          isl_val_zero(ctx));
+    else
+      trans_mat = isl_mat_set_element_val(trans_mat, isl_mat_cols(null_mat), i,
+                                          isl_vec_get_element_val(dir, i));
   }
   *io_trans_mat = trans_mat;
 
@@ -1358,6 +1472,54 @@ static __isl_give isl_schedule_node *io_cluster(
     ma = isl_multi_aff_set_aff(ma, i, aff);
   }
 
+  /* The transformation matrix of a multi-component direction may contain 
+   * negative coefficients, e.g., the projection vector [-1, 1] for the 
+   * direction [1, 1], or the scheduling vector [0, -1] for the direction 
+   * [-1, 1], which may lead to negative IO module ids.
+   * We shift each transformed dimension by its minimum over the band domain 
+   * so that the ids start from zero.
+   * The unit directions are left unshifted.
+   */
+  int has_neg = 0;
+  for (int i = 0; i < isl_mat_rows(trans_mat); i++)
+    for (int j = 0; j < isl_mat_cols(trans_mat); j++)
+    {
+      isl_val *val = isl_mat_get_element_val(trans_mat, i, j);
+      if (isl_val_is_neg(val))
+        has_neg = 1;
+      isl_val_free(val);
+    }
+  *io_trans_cst = isl_vec_zero(ctx, isl_mat_rows(trans_mat));
+  if (has_neg && n_non_zero > 1)
+  {
+    isl_union_set *domain = isl_schedule_node_get_domain(node);
+    domain = isl_union_set_apply(domain,
+                                 isl_union_map_from_multi_union_pw_aff(
+                                     isl_multi_union_pw_aff_copy(mupa)));
+    isl_set *range = isl_set_from_union_set(domain);
+    range = isl_set_apply(range, isl_map_from_multi_aff(isl_multi_aff_copy(ma)));
+    for (int i = 0; i < isl_mat_rows(trans_mat); i++)
+    {
+      isl_aff *obj = isl_aff_var_on_domain(
+          isl_local_space_from_space(isl_set_get_space(range)), isl_dim_set, i);
+      isl_val *min = isl_set_min_val(range, obj);
+      isl_aff_free(obj);
+      if (isl_val_is_int(min) && isl_val_is_neg(min))
+      {
+        isl_aff *aff = isl_multi_aff_get_aff(ma, i);
+        min = isl_val_neg(min);
+        *io_trans_cst = isl_vec_set_element_val(*io_trans_cst, i, isl_val_copy(min));
+        aff = isl_aff_add_constant_val(aff, min);
+        ma = isl_multi_aff_set_aff(ma, i, aff);
+      }
+      else
+      {
+        isl_val_free(min);
+      }
+    }
+    isl_set_free(range);
+  }
+
   /* Apply the new transformation on the original partial schedule. */
   mupa = isl_multi_union_pw_aff_apply_multi_aff(mupa, isl_multi_aff_copy(ma));
   *io_trans_ma = ma;
@@ -1366,17 +1528,32 @@ static __isl_give isl_schedule_node *io_cluster(
   /* Insert the new partial schedule. */
   node = isl_schedule_node_insert_partial_schedule(node, mupa);
   /* Add back the tuning iterators.
-   * Since all the io dirs are unit vectors, which means only loop permutation is 
-   * allowed, we simply swap the iter infos.
+   * For the unit io dirs, only loop permutation is applied, and we simply 
+   * swap the iter infos. Otherwise, each new loop takes the iter info of 
+   * one unused original loop that it depends on.
    */
   std::vector<int> swap_index;  
+  std::vector<bool> used(isl_mat_cols(*io_trans_mat), false);
   for (int i = 0; i < isl_mat_rows(*io_trans_mat); i++) {
-    int tmp = 0;
+    int tmp = -1;
     for (int j = 0; j < isl_mat_cols(*io_trans_mat); j++) {
       isl_val *val_tmp = isl_mat_get_element_val(*io_trans_mat, i, j);
-      tmp += isl_val_get_num_si(val_tmp) * j;
+      int is_zero = isl_val_is_zero(val_tmp);
       isl_val_free(val_tmp);
+      if (!is_zero && !used[j]) {
+        tmp = j;
+        break;
+      }
+    }
+    if (tmp == -1) {
+      for (int j = 0; j < isl_mat_cols(*io_trans_mat); j++) {
+        if (!used[j]) {
+          tmp = j;
+          break;
+        }
+      }
     }
+    used[tmp] = true;
     swap_index.push_back(tmp);
   }
   // Restore the loop iterators
@@ -2023,6 +2200,7 @@ static isl_stat compute_io_group_schedule(
   isl_id *id;
   isl_schedule *sched;
   isl_mat *io_trans_mat = NULL;
+  isl_vec *io_trans_cst = NULL;
   isl_multi_aff *io_trans_ma = NULL;
   isl_map *io_trans_map = NULL;
   isl_schedule_node *node;
@@ -2057,6 +2235,7 @@ static isl_stat compute_io_group_schedule(
   for (int i = space_dim - 1; i >= 0; i--)
   {
     isl_mat *io_trans_mat_i;
+    isl_vec *io_trans_cst_i;
     isl_multi_aff *io_trans_ma_i;
     isl_vec *dir;
     isl_mat *mat;
@@ -2072,7 +2251,7 @@ static isl_stat compute_io_group_schedule(
       dir = isl_vec_zero(ctx, i + 1);
       dir = isl_vec_set_element_si(dir, 0, 1);
     }
-    node = io_cluster(node, dir, &io_trans_mat_i, &io_trans_ma_i);
+    node = io_cluster(node, dir, &io_trans_mat_i, &io_trans_cst_i, &io_trans_ma_i);
     isl_vec_free(dir);
 
     if (io_level == 1)
@@ -2085,6 +2264,7 @@ static isl_stat compute_io_group_schedule(
 
       isl_schedule_free(sched);
       io_trans_mat = io_trans_mat_i;
+      io_trans_cst = io_trans_cst_i;
       io_trans_ma = io_trans_ma_i;
     }
     else
@@ -2126,10 +2306,27 @@ static isl_stat compute_io_group_schedule(
             product_mat = isl_mat_set_element_val(product_mat, r, c, v3);
           }
         }
+      /* The shift is transformed as well: E * (M * x + c) + c_i. */
+      isl_vec *product_cst = isl_vec_zero(ctx, nrow);
+      for (int r = 0; r < nrow; r++)
+      {
+        isl_val *v3 = r < isl_vec_size(io_trans_cst_i) ?
+                      isl_vec_get_element_val(io_trans_cst_i, r) : isl_val_zero(ctx);
+        for (int k = 0; k < nrow; k++)
+        {
+          isl_val *v1 = isl_mat_get_element_val(extend_mat, r, k);
+          isl_val *v2 = isl_vec_get_element_val(io_trans_cst, k);
+          v3 = isl_val_add(v3, isl_val_mul(v1, v2));
+        }
+        product_cst = isl_vec_set_element_val(product_cst, r, v3);
+      }
       isl_mat_free(io_trans_mat);
       isl_mat_free(extend_mat);
       isl_mat_free(io_trans_mat_i);
+      isl_vec_free(io_trans_cst);
+      isl_vec_free(io_trans_cst_i);
       io_trans_mat = product_mat;
+      io_trans_cst = product_cst;
 
       /* Reset the transformation function. */
       for (int r = 0; r < nrow; r++)
@@ -2141,6 +2338,7 @@ static isl_stat compute_io_group_schedule(
           aff = isl_aff_set_coefficient_si(aff, isl_dim_in, c, isl_val_get_num_si(val));          
           isl_val_free(val);
         }
+        aff = isl_aff_set_constant_val(aff, isl_vec_get_element_val(io_trans_cst, r));
         io_trans_ma = isl_multi_aff_set_aff(io_trans_ma, r, aff);
       }
     }
@@ -2200,6 +2398,7 @@ static isl_stat compute_io_group_schedule(
   }
 
   isl_mat_free(io_trans_mat);  
+  isl_vec_free(io_trans_cst);
 
   group->io_level = io_level;
   group->io_trans = io_trans_ma;
@@ -2801,7 +3000,7 @@ static isl_stat compute_io_group_buffer(struct autosa_kernel *kernel,
   isl_schedule_node *node;
   int io_level = group->io_level;
   int i;
-  int two_level_buffer = gen->options->autosa->two_level_buffer;
+  int two_level_buffer = group->two_level_buffer;
 
   node = isl_schedule_get_root(group->io_schedule);
 
@@ -4586,6 +4785,312 @@ static isl_stat autosa_io_clustering(struct autosa_kernel *kernel,
   return isl_stat_ok;
 }
 
+/* Estimate the BRAM18K usage of the local buffers inside all the PEs of "sa".
+ * Returns 0 if the array dimensions are not known.
+ */
+long sa_estimate_pe_buffer_bram18k(struct autosa_kernel *sa)
+{
+  long n_pe = 1;
+  long bram = 0;
+
+  for (int i = 0; i < sa->n_sa_dim; i++) {
+    if (sa->sa_dim[i] <= 0)
+      return 0;
+    n_pe *= sa->sa_dim[i];
+  }
+
+  for (int i = 0; i < sa->n_array; i++) {
+    struct autosa_local_array_info *local = &sa->array[i];
+    long n_part = 1;
+    /* The buffers are partitioned by the lcm of the data packing factors 
+     * of the I/O groups, the same as in create_pe_module_var. 
+     * The factors are not known before data packing. */
+    for (int j = 0; j < local->n_io_group; j++) {
+      long n_lane = local->io_groups[j]->n_lane > 0 ? local->io_groups[j]->n_lane : 1;
+      long a = n_part, b = n_lane;
+      while (b) {
+        long t = a % b;
+        a = b;
+        b = t;
+      }
+      n_part = n_part / a * n_lane;
+    }
+    for (int j = 0; j < local->n_pe_group; j++) {
+      struct autosa_array_ref_group *group = local->pe_groups[j];
+      struct autosa_array_tile *tile;
+      long depth = 1;
+
+      if (autosa_array_ref_group_type(group) == AUTOSA_ACCESS_GLOBAL)
+        continue;
+      tile = autosa_array_ref_group_tile(group);
+      for (int k = 0; tile && k < group->array->n_index; k++)
+        depth *= isl_val_get_num_si(tile->bound[k].size);
+      /* The PE buffers are not packed. Accumulators promoted to registers and
+       * small buffers use FF, the same as in extract_memory_type. */
+      if (autosa_local_buffer_use_reg(autosa_pe_acc_reg(sa, group, depth), 1, depth))
+        continue;
+      bram += n_pe * n_part * sa_estimate_bram18k(
+          group->array->size * 8, (depth + n_part - 1) / n_part);
+    }
+  }
+
+  return bram;
+}
+
+/* Return the number of the I/O module instances of "group" at io_L"level".
+ * The instances are enumerated by the I/O loops above the io_L"level" mark.
+ */
+long autosa_io_module_instance_cnt(struct autosa_kernel *kernel,
+                                   struct autosa_array_ref_group *group, int level)
+{
+  isl_schedule_node *node;
+  long cnt = 1;
+
+  node = isl_schedule_get_root(group->io_schedule);
+  node = autosa_tree_move_down_to_array(node, kernel->core);
+  while (!isl_schedule_node_is_io_mark(node, level))
+  {
+    if (isl_schedule_node_get_type(node) == isl_schedule_node_band)
+    {
+      int *ubs = extract_band_upper_bounds(node);
+      for (int i = 0; i < isl_schedule_node_band_n_member(node); i++)
+        cnt *= ubs[i];
+      free(ubs);
+    }
+    node = isl_schedule_node_child(node, 0);
+  }
+  isl_schedule_node_free(node);
+
+  return cnt;
+}
+
+/* Estimate the BRAM18K usage of the buffers of "group" allocated in all 
+ * the I/O modules at io_L"level". The data packing factor is taken into 
+ * account if it is already computed.
+ */
+long autosa_io_buffer_bram18k(struct autosa_kernel *kernel,
+                              struct autosa_array_ref_group *group, int level)
+{
+  struct autosa_io_buffer *buffer = group->io_buffers[level - 1];
+  long depth = 1;
+  long n_lane;
+
+  if (!buffer->tile)
+    return 0;
+  n_lane = buffer->n_lane > 0 ? buffer->n_lane : 1;
+  for (int i = 0; i < buffer->tile->n; i++)
+    depth *= isl_val_get_num_si(buffer->tile->bound[i].size);
+  /* Small buffers are mapped to registers, see extract_memory_type. */
+  if (depth <= 8)
+    return 0;
+
+  return autosa_io_module_instance_cnt(kernel, group, level) *
+         sa_estimate_bram18k(group->array->size * 8 * n_lane, (depth + n_lane - 1) / n_lane);
+}
+
+/* Is the buffer of "group" at the outermost I/O level a second-level buffer,
+ * i.e., is there any buffer allocated at the lower levels?
+ */
+static int is_two_level_buffer_candidate(struct autosa_array_ref_group *group)
+{
+  if (!group->two_level_buffer || !group->io_buffers[group->io_level - 1]->tile)
+    return 0;
+  for (int i = 0; i < group->io_level - 1; i++)
+  {
+    if (group->io_buffers[i]->tile)
+      return 1;
+  }
+  return 0;
+}
+
+/* The DRAM access latency of each burst in cycles. It is estimated as 200ns 
+ * at 200MHz, the same as in the latency model of the auto-tuner.
+ */
+#define AUTOSA_DRAM_BURST_LATENCY 40
+
+/* Return the number of times the buffer with tiling "tile" of "group" is 
+ * filled, i.e., the number of iterations of the loops above the buffer in 
+ * the I/O schedule. The buffer might have been hoisted above its I/O mark.
+ */
+static long autosa_io_buffer_fill_cnt(struct autosa_kernel *kernel,
+                                      struct autosa_array_ref_group *group, struct autosa_array_tile *tile)
+{
+  isl_schedule_node *node;
+  long cnt = 1;
+
+  node = isl_schedule_get_root(group->io_schedule);
+  node = autosa_tree_move_down_to_kernel(node);
+  while (isl_schedule_node_has_children(node))
+  {
+    enum isl_schedule_node_type type = isl_schedule_node_get_type(node);
+    if (type == isl_schedule_node_sequence || type == isl_schedule_node_set)
+      break;
+    if (type == isl_schedule_node_band)
+    {
+      int depth = isl_schedule_node_get_schedule_depth(node);
+      int n = isl_schedule_node_band_n_member(node);
+      int *ubs;
+      if (depth >= tile->depth)
+        break;
+      ubs = extract_band_upper_bounds(node);
+      for (int i = 0; i < n && depth + i < tile->depth; i++)
+        cnt *= ubs[i];
+      free(ubs);
+    }
+    node = isl_schedule_node_child(node, 0);
+  }
+  isl_schedule_node_free(node);
+
+  return cnt;
+}
+
+/* Estimate the number of cycles to load/store the buffer of "group" at 
+ * io_L"level" from/to the DRAM over the whole kernel.
+ * The innermost dimension of the buffer is accessed in bursts, each of 
+ * which pays the DRAM access latency.
+ */
+static long autosa_io_buffer_dram_cycles(struct autosa_kernel *kernel,
+                                         struct autosa_array_ref_group *group, int level)
+{
+  struct autosa_array_tile *tile = group->io_buffers[level - 1]->tile;
+  long elems = 1, burst_len;
+
+  for (int i = 0; i < tile->n; i++)
+    elems *= isl_val_get_num_si(tile->bound[i].size);
+  burst_len = isl_val_get_num_si(tile->bound[tile->n - 1].size);
+  if (burst_len <= 0)
+    burst_len = 1;
+
+  return autosa_io_buffer_fill_cnt(kernel, group, tile) *
+         (elems / burst_len) * (AUTOSA_DRAM_BURST_LATENCY + burst_len);
+}
+
+/* A second-level buffer that the automatic assignment decides on. 
+ * "dram" and "dram_wo" are the estimated DRAM access cycles of the I/O 
+ * group with and without the buffer.
+ */
+struct autosa_two_level_buffer_cand
+{
+  struct autosa_array_ref_group *group;
+  long bram;
+  long dram;
+  long dram_wo;
+};
+
+/* Deduct the PE buffers and the I/O buffers from the BRAM18K budget and 
+ * decide whether to keep the second-level buffer of each I/O group.
+ * The second-level buffers that are left after hoist_L2_io_buffer 
+ * increase the burst length or reduce the communication. 
+ * Without the second-level buffer, the DRAM is accessed by the buffer 
+ * at the next lower level. A second-level buffer is kept if it saves 
+ * at least 10% of the DRAM access cycles of the I/O group, the same 
+ * threshold as the double buffers. The buffers that save the most 
+ * cycles are kept first until the budget is used up.
+ * Only the buffers enabled by "--two-level-buffer" are considered, since 
+ * they require the second-level array partitioning.
+ * This is called in the automatic assignment even without two-level 
+ * buffering, since the budget left is used for assigning the double 
+ * buffers later.
+ */
+static isl_stat autosa_io_buffer_budget_assign(struct autosa_kernel *kernel,
+                                                  struct autosa_gen *gen)
+{
+  std::vector<struct autosa_two_level_buffer_cand> cands;
+  int has_budget = gen->io_bram18k_left >= 0;
+  long left = gen->io_bram18k_left;
+  cJSON *report;
+
+  if (has_budget)
+    left -= sa_estimate_pe_buffer_bram18k(kernel);
+  for (int i = 0; i < kernel->n_array; i++)
+  {
+    struct autosa_local_array_info *local = &kernel->array[i];
+    for (int j = 0; j <= local->n_io_group; j++)
+    {
+      struct autosa_array_ref_group *group = j < local->n_io_group ?
+                                             local->io_groups[j] : local->drain_group;
+      int candidate;
+      if (!group)
+        continue;
+      candidate = is_two_level_buffer_candidate(group);
+      for (int l = 1; l <= group->io_level; l++)
+      {
+        if (l == group->io_level && candidate)
+        {
+          struct autosa_two_level_buffer_cand cand;
+          int lower = group->io_level - 1;
+          while (!group->io_buffers[lower - 1]->tile)
+            lower--;
+          cand.group = group;
+          cand.bram = autosa_io_buffer_bram18k(kernel, group, l);
+          cand.dram = autosa_io_buffer_dram_cycles(kernel, group, l);
+          cand.dram_wo = autosa_io_buffer_dram_cycles(kernel, group, lower);
+          cands.push_back(cand);
+        }
+        else if (has_budget)
+          left -= autosa_io_buffer_bram18k(kernel, group, l);
+      }
+      if (!candidate && group->io_level > 1 && !group->io_buffers[group->io_level - 1]->tile)
+        group->two_level_buffer = 0;
+    }
+  }
+  if (left < 0)
+    left = 0;
+
+  std::stable_sort(cands.begin(), cands.end(),
+                   [](const struct autosa_two_level_buffer_cand &a,
+                      const struct autosa_two_level_buffer_cand &b) {
+                     return a.dram_wo - a.dram > b.dram_wo - b.dram;
+                   });
+  if (!cands.empty())
+  {
+    report = cJSON_CreateObject();
+    cJSON_AddItemToObject(gen->io_buffer_report, "two_level_buffer", report);
+  }
+  for (auto &cand : cands)
+  {
+    struct autosa_array_ref_group *group = cand.group;
+    struct autosa_io_buffer *buffer = group->io_buffers[group->io_level - 1];
+    int keep = (cand.dram_wo - cand.dram) * 10 >= cand.dram_wo;
+    cJSON *info;
+    isl_printer *p_str;
+    char *name;
+
+    if (keep && has_budget)
+    {
+      if (cand.bram > left)
+        keep = 0;
+      else
+        left -= cand.bram;
+    }
+    if (!keep)
+    {
+      autosa_array_tile_free(buffer->tile);
+      buffer->tile = NULL;
+      group->two_level_buffer = 0;
+    }
+
+    p_str = isl_printer_to_str(gen->ctx);
+    p_str = autosa_array_ref_group_print_prefix(group, p_str);
+    name = isl_printer_get_str(p_str);
+    isl_printer_free(p_str);
+    info = cJSON_CreateObject();
+    cJSON_AddNumberToObject(info, "enable", keep);
+    cJSON_AddNumberToObject(info, "dram_cycles", cand.dram);
+    cJSON_AddNumberToObject(info, "dram_cycles_wo", cand.dram_wo);
+    cJSON_AddNumberToObject(info, "BRAM18K", cand.bram);
+    cJSON_AddItemToObject(report, name, info);
+    if (gen->options->autosa->verbose)
+      printf("[AutoSA] Two-level buffer of %s: %s (DRAM: %ld, DRAM w/o: %ld, BRAM18K: %ld)\n",
+             name, keep ? "enabled" : "disabled", cand.dram, cand.dram_wo, cand.bram);
+    free(name);
+  }
+  if (has_budget)
+    gen->io_bram18k_left = left;
+
+  return isl_stat_ok;
+}
+
 /* Allocate I/O buffers inside I/O modules. */
 static isl_stat autosa_io_buffer_allocate(struct autosa_kernel *kernel,
                                           struct autosa_gen *gen, struct autosa_group_data *data)
@@ -4595,6 +5100,7 @@ static isl_stat autosa_io_buffer_allocate(struct autosa_kernel *kernel,
     struct autosa_local_array_info *local = &kernel->array[i];
     for (int j = 0; j < local->n_io_group; j++)
     {      
+      local->io_groups[j]->two_level_buffer = gen->options->autosa->two_level_buffer;
       compute_io_group_buffer(kernel, local->io_groups[j], gen);            
       if (!gen->options->autosa->lower_int_io_L1_buffer) {
         /* Hoist the L1 I/O buffer. 
@@ -4628,6 +5134,7 @@ static isl_stat autosa_io_buffer_allocate(struct autosa_kernel *kernel,
     }    
     if (local->drain_group)
     {      
+      local->drain_group->two_level_buffer = gen->options->autosa->two_level_buffer;
       compute_io_group_buffer(kernel, local->drain_group, gen);
       if (gen->options->autosa->two_level_buffer)
       {
@@ -4635,6 +5142,9 @@ static isl_stat autosa_io_buffer_allocate(struct autosa_kernel *kernel,
       }
     }
   }
+  if (gen->options->autosa->auto_buffer_assign)
+    autosa_io_buffer_budget_assign(kernel, gen);
+
   return isl_stat_ok;
 }
 
@@ -4744,11 +5254,13 @@ static void explore_loop_permute(struct autosa_kernel *kernel, struct autosa_gen
       struct autosa_array_ref_group *group = local->io_groups[j];      
       for (int r = 0; r < group->n_ref; r++) {
         struct autosa_stmt_access *ref = group->refs[r];
+        std::unordered_set<int> reuse_loops;
+        autosa_isl_budget_start(gen->ctx, gen->options);
         isl_map *acc = isl_map_from_union_map(isl_union_map_apply_domain(
                           isl_union_map_from_map(isl_map_copy(ref->access)),
                           isl_union_map_copy(prefix)));
-        int n_dim = isl_map_dim(acc, isl_dim_in);
-        std::unordered_set<int> reuse_loops;
+        bool failed = !acc;
+        int n_dim = failed ? 0 : isl_map_dim(acc, isl_dim_in);
         for (int d = 0; d < n_dim; d++) {
           /* We will test if the array elements accessed by the iterations that increased 
            * at position "d" is the same as the original array elements.
@@ -4762,7 +5274,8 @@ static void explore_loop_permute(struct autosa_kernel *kernel, struct autosa_gen
           isl_set *domain = isl_map_domain(isl_map_copy(map));
           isl_set *range = isl_map_range(isl_map_copy(map));          
           isl_map_free(map);
-          if (isl_set_is_subset(domain, range) && isl_set_is_subset(range, domain)) {            
+          if (isl_set_is_subset(domain, range) == isl_bool_true && 
+              isl_set_is_subset(range, domain) == isl_bool_true) {            
             //std::cout << d << std::endl;
             reuse_loops.insert(d);
           }          
@@ -4770,6 +5283,12 @@ static void explore_loop_permute(struct autosa_kernel *kernel, struct autosa_gen
           isl_set_free(range);
         }        
         isl_map_free(acc);
+        if (autosa_isl_budget_stop(gen->ctx) || failed) {
+          /* Skip the loop ordering of this reference. */
+          autosa_report_degradation(gen->options, "loop permutation",
+                                    "Skip the loop permutation candidate.");
+          continue;
+        }
         if (reuse_loops.size() > 0) {
           // Prune the duplicated ordering.
           int d = 0;
@@ -4784,37 +5303,65 @@ static void explore_loop_permute(struct autosa_kernel *kernel, struct autosa_gen
     }
   }  
   isl_union_map_free(prefix);
+
+  /* Compute the loop ordering of the array partitioning band produced by 
+   * each reuse set. Reuse sets leading to the same loop ordering 
+   * (e.g., the reuse loops are already innermost) are equivalent, and only 
+   * the first one is generated. The orderings keep their indices in 
+   * "loop_orderings", so that the design kernel[id]_[order] always refers 
+   * to the same ordering whether or not the duplicates are skipped.
+   */
+  node = isl_schedule_get_root(kernel->schedule);
+  node = autosa_tree_move_down_to_array(node, kernel->core);
+  node = isl_schedule_node_parent(node);
+  int n_dim = isl_schedule_node_band_n_member(node);
+  isl_schedule_node_free(node);
+  std::vector<std::vector<int>> permutations;
+  std::vector<int> unique_orderings;
+  for (int idx = 0; idx < loop_orderings.size(); idx++) {
+    std::unordered_set<int> &order = loop_orderings[idx];
+    /* "perm[p]" is the original loop at position "p". */
+    std::vector<int> perm;
+    std::unordered_map<int, int> pos_map;
+    for (int p = 0; p < n_dim; p++) {
+      perm.push_back(p);
+      pos_map[p] = p;
+    }
+    int n_processed = 0;
+    for (auto o : order) {
+      std::swap(perm[pos_map[o]], perm[n_dim - 1 - n_processed]);
+      pos_map[n_dim - 1 - n_processed] = pos_map[o];
+      pos_map[o] = n_dim - 1 - n_processed;
+      n_processed++;
+    }
+    if (std::find(permutations.begin(), permutations.end(), perm) == permutations.end()) {
+      permutations.push_back(perm);
+      unique_orderings.push_back(idx);
+    }
+  }
   n_order = loop_orderings.size();
 
-  /* When there is more than one loop permutation found,
-   * We will print a temp file named by the sequence of the next loop ordering to the 
-   * temporary directory. For example, when there are two orderings, 
-   * in the first-time compilation, we print a file named "permute_1" to the tmp directory.
-   * AutoSA wrapper script will then call the compilation again serving this index 
-   * as the next loop ordering to be selected.
-   * This process is iterated until all the orderings are explored.
-   * In the last ordering, we print "permute_done" instead, which will instruct the 
-   * wrapper script to stop calling the program.
+  /* When there is more than one loop ordering found, the designs of 
+   * all the orderings are generated in one run. The indices of the 
+   * orderings that are not duplicated are recorded in "gen", and AutoSA 
+   * will map the kernel again with each of them selected by 
+   * "loop_permute_order".
+   * The tuning information of each ordering is dumped to 
+   * "kernel[id]_[order].json".
    */
-  if (n_order == 1)
+  if (n_order <= 1)
     return;
 
   int cur_n_order = gen->options->autosa->loop_permute_order;
+  if (cur_n_order < 0)
+    cur_n_order = 0;
+  if (cur_n_order >= n_order) {
+    printf("[AutoSA] Error: Loop ordering %d is out of range (%d orderings found).\n", 
+      cur_n_order, n_order);
+    exit(1);
+  }
+  gen->loop_permute_orders = unique_orderings;
   if (gen->options->autosa->tuning_method == 1) {
-    /* Print the tmp file. */  
-    isl_printer *p_str = isl_printer_to_str(gen->ctx);
-    p_str = isl_printer_print_str(p_str, gen->options->autosa->output_dir);
-    p_str = isl_printer_print_str(p_str, "/permute_");
-    if (cur_n_order == n_order - 1) {
-      p_str = isl_printer_print_str(p_str, "done");
-    } else {
-      p_str = isl_printer_print_int(p_str, cur_n_order + 1);
-    }
-    char *file_name = isl_printer_get_str(p_str);
-    isl_printer_free(p_str);
-    FILE *fp = fopen(file_name, "w");
-    fclose(fp);    
-
     kernel->tuning_program->id2 = cur_n_order;
   }
 
@@ -4823,7 +5370,6 @@ static void explore_loop_permute(struct autosa_kernel *kernel, struct autosa_gen
   node = isl_schedule_get_root(kernel->schedule);
   node = autosa_tree_move_down_to_array(node, kernel->core);
   node = isl_schedule_node_parent(node);
-  int n_dim = isl_schedule_node_band_n_member(node);
   std::unordered_map<int, int> pos_map;
   for (int p = 0; p < n_dim; p++) {
     pos_map[p] = p;
@@ -4845,6 +5391,234 @@ static void explore_loop_permute(struct autosa_kernel *kernel, struct autosa_gen
   // TODO: Test if we need to update anything else
 }
 
+/* Collect the untagged RAW and RAR dependences of the references in "group" 
+ * into "deps". Each dependence is only added once.
+ */
+static void collect_group_live_deps(struct autosa_array_ref_group *group,
+                                    std::vector<isl_basic_map *> &deps)
+{
+  for (int i = 0; i < group->n_ref; i++)
+  {
+    struct autosa_stmt_access *ref = group->refs[i];
+    for (int j = 0; j < ref->n_io_info; j++)
+    {
+      struct autosa_dep *dep = ref->io_info[j]->dep;
+      isl_basic_map *untagged;
+      bool found = false;
+
+      if (dep->type != AUTOSA_DEP_RAW && dep->type != AUTOSA_DEP_RAR)
+        continue;
+      untagged = isl_basic_map_from_map(isl_map_factor_domain(
+          isl_map_from_basic_map(isl_basic_map_copy(dep->isl_dep))));
+      for (auto d : deps)
+      {
+        if (isl_basic_map_is_equal(d, untagged) == isl_bool_true)
+        {
+          found = true;
+          break;
+        }
+      }
+      if (found)
+        isl_basic_map_free(untagged);
+      else
+        deps.push_back(untagged);
+    }
+  }
+}
+
+/* Is any of the dependences in "deps" carried by a time loop above the 
+ * PE mark? The data of such dependences are live across the PE tiles, and 
+ * the local buffer can't be contracted.
+ */
+static bool live_deps_carried_above_pe(struct autosa_kernel *kernel,
+                                       const std::vector<isl_basic_map *> &deps)
+{
+  isl_schedule_node *node;
+  bool carried = false;
+
+  node = isl_schedule_get_root(kernel->schedule);
+  node = autosa_tree_move_down_to_pe(node, kernel->core);
+  while (!carried && isl_schedule_node_has_parent(node))
+  {
+    node = isl_schedule_node_parent(node);
+    if (isl_schedule_node_get_type(node) != isl_schedule_node_band)
+      continue;
+    int n = isl_schedule_node_band_n_member(node);
+    for (auto dep : deps)
+    {
+      std::vector<long> dis;
+      if (get_dep_dis_at_node_si(dep, node, dis) < 0)
+      {
+        carried = true;
+        break;
+      }
+      for (int i = 0; i < n && i < (int)dis.size(); i++)
+      {
+        if (dis[i] != 0 &&
+            isl_schedule_node_band_member_get_space_time(node, i) != autosa_loop_space)
+          carried = true;
+      }
+      if (carried)
+        break;
+    }
+  }
+  isl_schedule_node_free(node);
+
+  return carried;
+}
+
+/* Shrink the local buffers of the internal arrays inside PEs to the data
+ * that stay live under the PE schedule.
+ * This is only applied with "pe_buffer_contraction".
+ * The local buffer of an internal array is allocated at the PE level by default,
+ * holding the whole footprint of the PE tile. However, the data are only live
+ * across the iterations of the loops that carry the RAW/RAR dependences of 
+ * the array. The buffer is contracted to the footprint of the outermost of 
+ * such loops under the PE mark, or to a single register if none of these 
+ * loops carries any of them.
+ * The contraction is only legal if the data are transferred to/from the
+ * buffer at the statement level, i.e., no I/O group with interior I/O copies
+ * the whole tile at the PE level, and no dependence of the array is carried 
+ * by a time loop above the PE mark.
+ * Each array is contracted separately. This is skipped for the arrays already
+ * contracted when grouping the references.
+ * In the tuning mode, the tile of the tuning program is inferred at the 
+ * contracted level as well, so that the models match the generated design.
+ * Only internal arrays with a single PE group are handled. The PE buffers of 
+ * the external arrays are kept, and no rotating register buffers are built 
+ * for stencil-like reuse.
+ */
+static isl_stat autosa_pe_group_contract(struct autosa_kernel *kernel,
+                                         struct autosa_gen *gen)
+{
+  isl_ctx *ctx = kernel->ctx;
+  isl_schedule_node *node;
+  int pe_depth;
+
+  if (!kernel->options->autosa->pe_buffer_contraction)
+    return isl_stat_ok;
+
+  node = isl_schedule_get_root(kernel->schedule);
+  node = autosa_tree_move_down_to_pe(node, kernel->core);
+  pe_depth = isl_schedule_node_get_schedule_depth(node);
+  isl_schedule_node_free(node);
+
+  for (int i = 0; i < kernel->n_array; i++)
+  {
+    struct autosa_local_array_info *local = &kernel->array[i];
+    struct autosa_array_ref_group *group;
+    struct check_contraction_data contract_data;
+    struct autosa_array_tile *tile;
+    isl_union_map *access;
+    isl_map *acc;
+    isl_bool ok;
+    bool legal = true;
+
+    if (local->array_type != AUTOSA_INT_ARRAY || local->n_pe_group != 1)
+      continue;
+    group = local->pe_groups[0];
+    if (!group->local_tile || group->copy_schedule_dim != pe_depth)
+      continue;
+    for (int j = 0; j < local->n_io_group; j++)
+    {
+      if (local->io_groups[j]->io_type == AUTOSA_INT_IO &&
+          local->io_groups[j]->pe_io_dir != IO_NULL)
+        legal = false;
+    }
+    if (!legal)
+      continue;
+
+    contract_data.group = group;
+    contract_data.kernel = kernel;
+    contract_data.legal = true;
+    contract_data.live_range = true;
+    contract_data.prefix = NULL;
+    contract_data.prefix_upma = NULL;
+    contract_data.depth = -1;
+    contract_data.tile_node = NULL;
+    collect_group_live_deps(group, contract_data.deps);
+    autosa_isl_budget_start(ctx, kernel->options);
+    if (contract_data.deps.empty() ||
+        live_deps_carried_above_pe(kernel, contract_data.deps))
+    {
+      contract_data.legal = false;
+    }
+    else
+    {
+      node = isl_schedule_get_root(kernel->schedule);
+      node = autosa_tree_move_down_to_pe(node, kernel->core);
+      node = isl_schedule_node_map_descendant_bottom_up(node, &check_contraction, &contract_data);
+      if (!node)
+        contract_data.legal = false;
+      isl_schedule_node_free(node);
+    }
+    for (auto dep : contract_data.deps)
+      isl_basic_map_free(dep);
+    if (autosa_isl_budget_stop(ctx))
+    {
+      autosa_report_degradation(kernel->options, "array contraction",
+                                "Keep the local buffer at the PE level.");
+      contract_data.legal = false;
+    }
+    if (!contract_data.legal || !contract_data.prefix || contract_data.depth <= pe_depth)
+    {
+      isl_union_map_free(contract_data.prefix);
+      isl_union_pw_multi_aff_free(contract_data.prefix_upma);
+      isl_schedule_node_free(contract_data.tile_node);
+      continue;
+    }
+
+    access = autosa_array_ref_group_access_relation(group, 1, 1);
+    acc = isl_map_from_union_map(isl_union_map_apply_domain(access, contract_data.prefix));
+    tile = autosa_array_tile_create(ctx, group->array->n_index);
+    ok = can_tile(acc, tile);
+    isl_map_free(acc);
+    if (ok < 0)
+    {
+      autosa_array_tile_free(tile);
+      isl_union_pw_multi_aff_free(contract_data.prefix_upma);
+      isl_schedule_node_free(contract_data.tile_node);
+      return isl_stat_error;
+    }
+    if (!ok)
+    {
+      autosa_array_tile_free(tile);
+      isl_union_pw_multi_aff_free(contract_data.prefix_upma);
+      isl_schedule_node_free(contract_data.tile_node);
+      continue;
+    }
+
+    isl_val *old_size = autosa_array_tile_size(group->local_tile);
+    isl_val *new_size = autosa_array_tile_size(tile);
+    if (isl_val_lt(new_size, old_size))
+    {
+      printf("[AutoSA] Contract the local buffer of array %s: %ld -> %ld elements.\n",
+             local->array->name, isl_val_get_num_si(old_size), isl_val_get_num_si(new_size));
+      autosa_array_tile_free(group->local_tile);
+      group->local_tile = tile;
+      isl_union_pw_multi_aff_free(group->copy_schedule);
+      group->copy_schedule_dim = contract_data.depth;
+      group->copy_schedule = isl_union_pw_multi_aff_pullback_union_pw_multi_aff(
+          contract_data.prefix_upma, isl_union_pw_multi_aff_copy(kernel->contraction));
+      if (gen->options->autosa->tuning_method == 1 && contract_data.tile_node)
+      {
+        delete group->tuning_local_tile;
+        group->tuning_local_tile = TP_infer_tiled_array(gen, kernel, contract_data.tile_node, group, 1, 1);
+      }
+    }
+    else
+    {
+      autosa_array_tile_free(tile);
+      isl_union_pw_multi_aff_free(contract_data.prefix_upma);
+    }
+    isl_schedule_node_free(contract_data.tile_node);
+    isl_val_free(old_size);
+    isl_val_free(new_size);
+  }
+
+  return isl_stat_ok;
+}
+
 /* Group references of all arrays in "kernel".
  * Each array is associated with three types of groups:
  * PE group: Assign the local buffers inside PEs.
@@ -4955,6 +5729,9 @@ isl_stat sa_io_construct_optimize(struct autosa_kernel *kernel, struct autosa_ge
     }
   }
 
+  /* PE buffer contraction */
+  autosa_pe_group_contract(kernel, gen);
+
   if (gen->options->autosa->host_serialize)
   {
     /* Check if there is only one I/O/drain group for each array.
@@ -4983,11 +5760,14 @@ isl_stat sa_io_construct_optimize(struct autosa_kernel *kernel, struct autosa_ge
       }
     }
   }
-  if (gen->options->autosa->host_serialize)
+  if (gen->options->autosa->host_serialize && gen->options->autosa->two_level_buffer)
   {
     /* Disable the two-level buffering when host data serialization is enabled. */
     gen->options->autosa->two_level_buffer = 0;
-    printf("[AutoSA] Warning: Two-level buffering is disabled because host data serialization is enabled.\n");
+    if (gen->options->autosa->auto_buffer_assign)
+      printf("[AutoSA] Warning: Two-level buffering is disabled because host data serialization is enabled, the second-level buffers are not considered in the automatic buffer assignment.\n");
+    else
+      printf("[AutoSA] Warning: Two-level buffering is disabled because host data serialization is enabled.\n");
   }
   if (gen->options->autosa->host_serialize && gen->options->autosa->hbm)
   {
@@ -8,6 +8,11 @@ extern "C" {
 #endif   
 
 isl_stat sa_io_construct_optimize(struct autosa_kernel *kernel, struct autosa_gen *gen);
+long sa_estimate_pe_buffer_bram18k(struct autosa_kernel *sa);
+long autosa_io_module_instance_cnt(struct autosa_kernel *kernel,
+  struct autosa_array_ref_group *group, int level);
+long autosa_io_buffer_bram18k(struct autosa_kernel *kernel,
+  struct autosa_array_ref_group *group, int level);
 enum autosa_group_access_type autosa_array_ref_group_type(
 	struct autosa_array_ref_group *group);
 enum autosa_group_access_type autosa_cpu_array_ref_group_type(
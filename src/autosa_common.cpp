@@ -1,5 +1,9 @@
 /* Defines functions used for AutoSA structs. */
 
+#include <map>
+#include <string>
+#include <algorithm>
+
 #include <isl/id.h>
 #include <cJSON/cJSON.h>
 
@@ -86,6 +90,7 @@ struct autosa_kernel *autosa_kernel_copy(struct autosa_kernel *kernel)
   {
     kernel_dup->sa_dim[i] = kernel->sa_dim[i];
   }
+  kernel_dup->simd_w = kernel->simd_w;
   kernel_dup->array_part_w = kernel->array_part_w;
   kernel_dup->space_w = kernel->space_w;
   kernel_dup->time_w = kernel->time_w;
@@ -151,6 +156,7 @@ struct autosa_kernel *autosa_kernel_from_schedule(__isl_take isl_schedule *sched
   kernel->prog = NULL;
   kernel->options = NULL;
   kernel->n_sa_dim = 0;
+  kernel->simd_w = 1;
   kernel->array_part_w = 0;
   kernel->space_w = 0;
   kernel->time_w = 0;
@@ -212,6 +218,7 @@ struct autosa_kernel *autosa_kernel_alloc(isl_ctx *ctx, struct ppcg_scop *scop)
   kernel->prog = NULL;
   kernel->options = NULL;
   kernel->n_sa_dim = 0;
+  kernel->simd_w = 1;
   kernel->array_part_w = 0;
   kernel->space_w = 0;
   kernel->time_w = 0;
@@ -983,6 +990,7 @@ struct autosa_array_ref_group *autosa_array_ref_group_init(
   group->n_lane = 0;
   group->copy_schedule_dim = 0;
   group->copy_schedule = NULL;
+  group->two_level_buffer = 0;
   group->attached_drain_group = NULL;
   group->tuning_pe_tile = NULL;
   group->tuning_local_tile = NULL;
@@ -1410,6 +1418,7 @@ void autosa_kernel_stmt_free(void *user)
     break;
   case AUTOSA_KERNEL_STMT_DRAIN_MERGE:
     isl_ast_expr_free(stmt->u.dm.index);
+    free(stmt->u.dm.contiguous_iter);
     break;
   case AUTOSA_KERNEL_STMT_HOST_SERIALIZE:
     isl_ast_expr_free(stmt->u.s.index);
@@ -1585,6 +1594,7 @@ struct autosa_hw_module *autosa_hw_module_alloc(struct autosa_gen *gen)
   module->coalesce_bound = -1;
   module->is_serialized = 0;
   module->use_FF = 0;
+  module->free_running = 0;
   module->in = -1;
   module->pipeline_at_default_func = 0;
   module->pipeline_at_filter_func[0] = 0;
@@ -3034,6 +3044,53 @@ TPArrayTile *TP_infer_tiled_array(
   return array_tile;
 }
 
+/* Is "group" an accumulator inside the PE that can be promoted to registers?
+ * The group should belong to an internal array that is both read and written
+ * by the PE, e.g., local_C in C[i][j] += A[i][k] * B[k][j].
+ * The accumulator is promoted only if the distance of its RAW dependence in 
+ * the pipelined loops covers the accumulation latency, i.e., the element 
+ * updated at one iteration is not touched again until "acc_latency" cycles 
+ * later (see autosa_pe_acc_dep_dis).
+ * The accumulator has "n_ele" elements and is promoted only if it has no more
+ * than "acc_reg_max" elements.
+ * The registers are only generated for Xilinx HLS.
+ */
+int autosa_pe_acc_reg(struct autosa_kernel *kernel,
+                      struct autosa_array_ref_group *group, long n_ele)
+{
+  int acc_latency = kernel->options->autosa->acc_latency;
+  int read = 0, write = 0;
+
+  if (acc_latency <= 0 || kernel->options->target != AUTOSA_TARGET_XILINX_HLS_C)
+    return 0;
+  if (group->local_array->array_type != AUTOSA_INT_ARRAY)
+    return 0;
+  if (group->local_array->is_sparse)
+    return 0;
+  for (int i = 0; i < group->n_ref; i++)
+  {
+    read |= group->refs[i]->read;
+    write |= group->refs[i]->write;
+  }
+  if (!read || !write)
+    return 0;
+  if (n_ele > kernel->options->autosa->acc_reg_max)
+    return 0;
+
+  return autosa_pe_acc_dep_dis(kernel, group) >= acc_latency;
+}
+
+/* Is the local buffer of "n_ele" elements with "n_lane" lanes inside a PE or 
+ * an I/O module at io_L1 mapped to registers? "acc_reg" is set if the buffer 
+ * is an accumulator promoted to registers (see autosa_pe_acc_reg).
+ * This is the memory mapping used by extract_memory_type, shared with the 
+ * resource estimation before code generation.
+ */
+int autosa_local_buffer_use_reg(int acc_reg, int n_lane, long n_ele)
+{
+  return acc_reg || (n_lane == 1 && n_ele <= 8);
+}
+
 /* Extract the memory type of the local array.
  * Heuristics: 
  * Compute the buffer utilization (18Kb BRAM):
@@ -3041,6 +3098,7 @@ TPArrayTile *TP_infer_tiled_array(
  * - Otherwise, util = #ele / 512
  * 
  * If the local buffer is inside PE module or I/O/drain module at IO_L1:
+ * - If the buffer is an accumulator promoted to registers, use FF
  * - If the buffer uses primitive type (n_lane == 1) and #ele <= 32, use FF
  * - Otherwise, use BRAM
  * Otherwise:
@@ -3082,7 +3140,7 @@ int extract_memory_type(struct autosa_hw_module *module,
     //  else
     //    use_memory = 2;    
     //}    
-    if (var->n_lane == 1 && var_size <= 8)
+    if (autosa_local_buffer_use_reg(var->acc_reg, var->n_lane, var_size))
         use_memory = 0;
       else
         use_memory = 2;
@@ -3257,6 +3315,631 @@ static cJSON *extract_design_info_from_pe_dummy_module(struct autosa_gen *gen,
   return info;
 }
 
+/* Evaluate the integer AST expression "expr" under the iterator values in
+ * "iters". Return isl_stat_error if "expr" refers to an unknown identifier,
+ * e.g., a program parameter, or contains an unsupported operation.
+ */
+static isl_stat eval_ast_expr(__isl_keep isl_ast_expr *expr,
+                              std::map<std::string, long> &iters, long *val)
+{
+  enum isl_ast_expr_type type = isl_ast_expr_get_type(expr);
+  if (type == isl_ast_expr_int)
+  {
+    isl_val *v = isl_ast_expr_get_val(expr);
+    *val = isl_val_get_num_si(v);
+    isl_val_free(v);
+    return isl_stat_ok;
+  }
+  if (type == isl_ast_expr_id)
+  {
+    isl_id *id = isl_ast_expr_get_id(expr);
+    auto it = iters.find(isl_id_get_name(id));
+    isl_id_free(id);
+    if (it == iters.end())
+      return isl_stat_error;
+    *val = it->second;
+    return isl_stat_ok;
+  }
+  if (type != isl_ast_expr_op)
+    return isl_stat_error;
+
+  int n_arg = isl_ast_expr_op_get_n_arg(expr);
+  std::vector<long> args(n_arg);
+  for (int i = 0; i < n_arg; i++)
+  {
+    isl_ast_expr *arg = isl_ast_expr_op_get_arg(expr, i);
+    isl_stat r = eval_ast_expr(arg, iters, &args[i]);
+    isl_ast_expr_free(arg);
+    if (r < 0)
+      return isl_stat_error;
+  }
+
+  switch (isl_ast_expr_get_op_type(expr))
+  {
+  case isl_ast_op_and:
+  case isl_ast_op_and_then:
+    *val = args[0] && args[1];
+    break;
+  case isl_ast_op_or:
+  case isl_ast_op_or_else:
+    *val = args[0] || args[1];
+    break;
+  case isl_ast_op_max:
+    *val = args[0];
+    for (int i = 1; i < n_arg; i++)
+      *val = std::max(*val, args[i]);
+    break;
+  case isl_ast_op_min:
+    *val = args[0];
+    for (int i = 1; i < n_arg; i++)
+      *val = std::min(*val, args[i]);
+    break;
+  case isl_ast_op_minus:
+    *val = -args[0];
+    break;
+  case isl_ast_op_add:
+    *val = args[0] + args[1];
+    break;
+  case isl_ast_op_sub:
+    *val = args[0] - args[1];
+    break;
+  case isl_ast_op_mul:
+    *val = args[0] * args[1];
+    break;
+  case isl_ast_op_div:
+  case isl_ast_op_pdiv_q:
+    if (args[1] == 0)
+      return isl_stat_error;
+    *val = args[0] / args[1];
+    break;
+  case isl_ast_op_fdiv_q:
+    if (args[1] == 0)
+      return isl_stat_error;
+    *val = args[0] / args[1];
+    if ((args[0] % args[1] != 0) && ((args[0] < 0) != (args[1] < 0)))
+      *val -= 1;
+    break;
+  case isl_ast_op_pdiv_r:
+  case isl_ast_op_zdiv_r:
+    if (args[1] == 0)
+      return isl_stat_error;
+    *val = args[0] % args[1];
+    break;
+  case isl_ast_op_cond:
+  case isl_ast_op_select:
+    *val = args[0] ? args[1] : args[2];
+    break;
+  case isl_ast_op_eq:
+    *val = args[0] == args[1];
+    break;
+  case isl_ast_op_le:
+    *val = args[0] <= args[1];
+    break;
+  case isl_ast_op_lt:
+    *val = args[0] < args[1];
+    break;
+  case isl_ast_op_ge:
+    *val = args[0] >= args[1];
+    break;
+  case isl_ast_op_gt:
+    *val = args[0] > args[1];
+    break;
+  default:
+    return isl_stat_error;
+  }
+
+  return isl_stat_ok;
+}
+
+/* Maximal number of loop iterations to interpret when counting the
+ * module and fifo instances.
+ */
+#define AUTOSA_MAX_COUNT_ITER (1 << 24)
+
+/* Data used when counting the module and fifo instances in the top module.
+ * "iters" holds the values of the enclosing loop iterators.
+ * "n_modules" maps each module name to its number of instances.
+ * "n_fifos" is the number of fifos declared.
+ * "n_iter" is the number of loop iterations interpreted so far.
+ */
+struct count_top_module_data
+{
+  std::map<std::string, long> iters;
+  std::map<std::string, long> n_modules;
+  long n_fifos;
+  long n_iter;
+};
+
+static isl_stat count_top_module_stmt(__isl_keep isl_ast_node *node,
+                                      struct count_top_module_data *data)
+{
+  isl_id *id = isl_ast_node_get_annotation(node);
+  if (!id)
+    return isl_stat_ok;
+  struct autosa_kernel_stmt *stmt = (struct autosa_kernel_stmt *)isl_id_get_user(id);
+  isl_id_free(id);
+
+  if (stmt->type == AUTOSA_KERNEL_STMT_MODULE_CALL)
+  {
+    /* Counted the same way as in autosa_kernel_print_module_call. */
+    struct autosa_hw_module *module = stmt->u.m.module;
+    std::string name(stmt->u.m.module_name);
+    if (stmt->u.m.upper || stmt->u.m.lower)
+      return isl_stat_ok;
+    data->n_modules[stmt->u.m.boundary ? name + "_boundary" : name]++;
+    if (module->is_filter && module->is_buffer)
+    {
+      data->n_modules[name + "_intra_trans"]++;
+      data->n_modules[stmt->u.m.boundary ? name + "_inter_trans_boundary" : name + "_inter_trans"]++;
+    }
+  }
+  else if (stmt->type == AUTOSA_KERNEL_STMT_FIFO_DECL)
+  {
+    /* Counted the same way as in print_fifo_decl. */
+    struct autosa_hw_module *module = stmt->u.m.module;
+    struct autosa_array_ref_group *group = stmt->u.m.group;
+    if (group->io_type == AUTOSA_INT_IO && module->type == PE_MODULE && group->pe_io_dir == IO_INOUT)
+      data->n_fifos += 2;
+    else
+      data->n_fifos += 1;
+  }
+
+  return isl_stat_ok;
+}
+
+/* Interpret the AST of the top module to count the module calls and fifo
+ * declarations, the same way as the generated top_gen program does.
+ */
+static isl_stat count_top_module_node(__isl_keep isl_ast_node *node,
+                                      struct count_top_module_data *data)
+{
+  isl_stat r = isl_stat_ok;
+
+  switch (isl_ast_node_get_type(node))
+  {
+  case isl_ast_node_for:
+  {
+    isl_ast_expr *iterator = isl_ast_node_for_get_iterator(node);
+    isl_ast_expr *init = isl_ast_node_for_get_init(node);
+    isl_ast_node *body = isl_ast_node_for_get_body(node);
+    isl_id *id = isl_ast_expr_get_id(iterator);
+    std::string name(isl_id_get_name(id));
+    isl_id_free(id);
+    long i;
+
+    r = eval_ast_expr(init, data->iters, &i);
+    if (r == isl_stat_ok && isl_ast_node_for_is_degenerate(node))
+    {
+      data->iters[name] = i;
+      r = count_top_module_node(body, data);
+    }
+    else if (r == isl_stat_ok)
+    {
+      isl_ast_expr *cond = isl_ast_node_for_get_cond(node);
+      isl_ast_expr *inc = isl_ast_node_for_get_inc(node);
+      while (r == isl_stat_ok)
+      {
+        long c, step = 1;
+        data->iters[name] = i;
+        r = eval_ast_expr(cond, data->iters, &c);
+        if (r < 0 || !c)
+          break;
+        if (++data->n_iter > AUTOSA_MAX_COUNT_ITER)
+        {
+          r = isl_stat_error;
+          break;
+        }
+        r = count_top_module_node(body, data);
+        if (r == isl_stat_ok)
+          r = eval_ast_expr(inc, data->iters, &step);
+        if (r == isl_stat_ok && step <= 0)
+          r = isl_stat_error;
+        i += step;
+      }
+      isl_ast_expr_free(cond);
+      isl_ast_expr_free(inc);
+    }
+    data->iters.erase(name);
+    isl_ast_expr_free(iterator);
+    isl_ast_expr_free(init);
+    isl_ast_node_free(body);
+    break;
+  }
+  case isl_ast_node_if:
+  {
+    isl_ast_expr *cond = isl_ast_node_if_get_cond(node);
+    long c;
+    r = eval_ast_expr(cond, data->iters, &c);
+    isl_ast_expr_free(cond);
+    if (r < 0)
+      break;
+    isl_ast_node *child = c ? isl_ast_node_if_get_then_node(node) : isl_ast_node_if_get_else_node(node);
+    if (child)
+      r = count_top_module_node(child, data);
+    isl_ast_node_free(child);
+    break;
+  }
+  case isl_ast_node_block:
+  {
+    isl_ast_node_list *children = isl_ast_node_block_get_children(node);
+    int n = isl_ast_node_list_n_ast_node(children);
+    for (int i = 0; i < n && r == isl_stat_ok; i++)
+    {
+      isl_ast_node *child = isl_ast_node_list_get_ast_node(children, i);
+      r = count_top_module_node(child, data);
+      isl_ast_node_free(child);
+    }
+    isl_ast_node_list_free(children);
+    break;
+  }
+  case isl_ast_node_mark:
+  {
+    isl_ast_node *child = isl_ast_node_mark_get_node(node);
+    r = count_top_module_node(child, data);
+    isl_ast_node_free(child);
+    break;
+  }
+  case isl_ast_node_user:
+    r = count_top_module_stmt(node, data);
+    break;
+  default:
+    break;
+  }
+
+  return r;
+}
+
+/* BRAM18K usage of a memory with "width" bits and "depth" entries. */
+long sa_estimate_bram18k(long width, long depth)
+{
+  if (width <= 18)
+    return ((width + 17) / 18) * ((depth + 1023) / 1024);
+  else
+    return ((width + 35) / 36) * ((depth + 511) / 512);
+}
+
+/* Resolve the typedef'd element type "type" to its underlying type,
+ * using the type definitions collected by pet, e.g., "data_t" is resolved
+ * to "float" with the definition "typedef float data_t".
+ */
+static std::string resolve_element_type(struct autosa_prog *prog, const char *type)
+{
+  std::string name(type);
+
+  /* Bound the number of steps in case of self-referencing definitions. */
+  for (int step = 0; step < prog->scop->pet->n_type; step++)
+  {
+    struct pet_type *def = NULL;
+    for (int i = 0; i < prog->scop->pet->n_type; i++)
+      if (name == prog->scop->pet->types[i]->name)
+        def = prog->scop->pet->types[i];
+    if (!def)
+      break;
+    std::string definition(def->definition);
+    std::string prefix("typedef ");
+    std::string suffix = std::string(" ") + name;
+    if (definition.compare(0, prefix.size(), prefix) ||
+        definition.size() <= prefix.size() + suffix.size() ||
+        definition.compare(definition.size() - suffix.size(), suffix.size(), suffix))
+      break;
+    name = definition.substr(prefix.size(),
+                             definition.size() - prefix.size() - suffix.size());
+  }
+
+  return name;
+}
+
+/* Number of DSPs used by the multiplications and additions of the data type
+ * "type" of "size" bytes.
+ */
+static int dsp_predict(const std::string &type, int size, int n_mul, int n_add)
+{
+  if (type == "float")
+    return 3 * n_mul + 2 * n_add;
+  if (type == "double")
+    return 11 * n_mul + 3 * n_add;
+  if (size <= 2)
+    return n_mul;
+  if (size <= 4)
+    return 3 * n_mul;
+  return 10 * n_mul;
+}
+
+struct count_stmt_op_data
+{
+  int n_mul;
+  int n_add;
+};
+
+static int count_stmt_op(__isl_keep pet_expr *expr, void *user)
+{
+  struct count_stmt_op_data *data = (struct count_stmt_op_data *)user;
+
+  if (pet_expr_get_type(expr) == pet_expr_op)
+  {
+    switch (pet_expr_op_get_type(expr))
+    {
+    case pet_op_mul:
+    case pet_op_mul_assign:
+      data->n_mul++;
+      break;
+    case pet_op_add:
+    case pet_op_sub:
+    case pet_op_add_assign:
+    case pet_op_sub_assign:
+      data->n_add++;
+      break;
+    default:
+      break;
+    }
+  }
+  for (int i = 0; i < pet_expr_get_n_arg(expr); i++)
+  {
+    pet_expr *arg = pet_expr_get_arg(expr, i);
+    count_stmt_op(arg, user);
+    pet_expr_free(arg);
+  }
+
+  return 0;
+}
+
+struct estimate_stmt_dsp_data
+{
+  struct autosa_prog *prog;
+  int dsp;
+};
+
+/* Add the number of DSPs used by the statement with the domain "set" to 
+ * "data->dsp". The statement is assumed to be computed in the data type of 
+ * the array it writes to, with typedefs resolved.
+ */
+static isl_stat estimate_stmt_dsp(__isl_take isl_set *set, void *user)
+{
+  struct estimate_stmt_dsp_data *data = (struct estimate_stmt_dsp_data *)user;
+  struct autosa_prog *prog = data->prog;
+  struct count_stmt_op_data op_data = {0, 0};
+  struct autosa_array_info *array = NULL;
+  struct autosa_stmt *stmt;
+  isl_id *id;
+
+  id = isl_set_get_tuple_id(set);
+  isl_set_free(set);
+  stmt = find_stmt(prog, id);
+  isl_id_free(id);
+  if (!stmt)
+    return isl_stat_ok;
+
+  pet_tree_foreach_expr(stmt->stmt->body, &count_stmt_op, &op_data);
+  for (struct autosa_stmt_access *access = stmt->accesses; access; access = access->next)
+  {
+    if (!access->write)
+      continue;
+    const char *name = isl_map_get_tuple_name(access->access, isl_dim_out);
+    for (int j = 0; j < prog->n_array; j++)
+      if (name && !strcmp(prog->array[j].name, name))
+        array = &prog->array[j];
+  }
+  if (!array)
+    return isl_stat_ok;
+  data->dsp += dsp_predict(resolve_element_type(prog, array->type), array->size,
+                           op_data.n_mul, op_data.n_add);
+
+  return isl_stat_ok;
+}
+
+/* Estimate the number of DSPs used by a single PE of "kernel". 
+ * Only the statements in the core computation of the kernel are counted, 
+ * and the operators are duplicated by the SIMD factor.
+ */
+int sa_estimate_pe_dsp(struct autosa_prog *prog, struct autosa_kernel *kernel)
+{
+  struct estimate_stmt_dsp_data data = {prog, 0};
+
+  if (!kernel->core)
+    return 0;
+  if (isl_union_set_foreach_set(kernel->core, &estimate_stmt_dsp, &data) < 0)
+    return 0;
+
+  return data.dsp * kernel->simd_w;
+}
+
+/* Estimate the BRAM18K/URAM usage of a single instance of "module".
+ * The memory type of each local buffer is decided the same way as in
+ * extract_buffer_info_from_module. Buffers mapped to registers or LUTRAM 
+ * are not counted.
+ */
+static void estimate_module_memory(struct autosa_gen *gen,
+                                   struct autosa_hw_module *module, long *bram, long *uram)
+{
+  *bram = *uram = 0;
+  for (int i = 0; i < module->n_var; i++)
+  {
+    struct autosa_kernel_var *var = &module->var[i];
+    long width = (long)var->n_lane * var->array->size * 8;
+    long depth = 1;
+    long n_part = var->n_part > 0 ? var->n_part : 1;
+    long part_depth;
+    int n_buf = module->double_buffer ? 2 : 1;
+    int mem_type;
+
+    for (int j = 0; j < isl_vec_size(var->size); j++)
+    {
+      isl_val *v = isl_vec_get_element_val(var->size, j);
+      depth *= isl_val_get_num_si(v);
+      isl_val_free(v);
+    }
+    part_depth = (depth + n_part - 1) / n_part;
+    mem_type = extract_memory_type(module, var, gen->options->autosa->uram);
+    if (mem_type == 2)
+      *bram += n_buf * n_part * sa_estimate_bram18k(width, part_depth);
+    else if (mem_type == 3)
+      *uram += n_buf * n_part * ((width + 71) / 72) * ((part_depth + 4095) / 4096);
+  }
+}
+
+/* BRAM18K usage of a fifo with "width" bits and "depth" entries. 
+ * Shallow fifos are implemented with SRLs and don't use any BRAM.
+ */
+static long estimate_fifo_bram18k(int width, int depth)
+{
+  if ((long)width * depth <= 512)
+    return 0;
+  return ((width + 17) / 18) * ((depth + 1023) / 1024);
+}
+
+/* Extract the resource usage of "cnt" fifos with "width" bytes, and add
+ * their BRAM usage to "total_bram".
+ */
+static cJSON *extract_fifo_resource(long cnt, int width,
+                                    int depth, long *total_bram)
+{
+  cJSON *info = cJSON_CreateObject();
+  long bram = estimate_fifo_bram18k(width * 8, depth);
+
+  cJSON_AddNumberToObject(info, "fifo_cnt", cnt);
+  cJSON_AddNumberToObject(info, "fifo_width", width);
+  cJSON_AddNumberToObject(info, "fifo_depth", depth);
+  cJSON_AddNumberToObject(info, "BRAM18K", bram);
+  *total_bram += cnt * bram;
+
+  return info;
+}
+
+/* Estimate the DSP/BRAM18K/URAM usage of the design on Xilinx FPGAs with
+ * the analytical models of the local buffers, fifos and PE operators, and
+ * dump it to "resource_est/design_resource.json".
+ * The module and fifo instances are counted by interpreting the AST of the
+ * top module. If the AST cannot be interpreted, e.g., it depends on the
+ * program parameters, no estimate is generated.
+ * The resources of each module and fifo are reported per instance.
+ * The total DSP, BRAM18K and URAM usage is stored in "usage" if the 
+ * estimate is generated. Otherwise, "usage" is left untouched.
+ */
+isl_stat sa_estimate_design_resource(struct autosa_gen *gen, long *usage)
+{
+  struct autosa_hw_top_module *top = gen->hw_top_module;
+  struct count_top_module_data data;
+  int fifo_depth = gen->options->autosa->fifo_depth;
+  long total_bram = 0, total_uram = 0, total_dsp = 0;
+  long total_fifos = 0;
+  int pe_dsp;
+  std::vector<long> n_fifos;
+
+  data.n_fifos = 0;
+  data.n_iter = 0;
+  for (int i = 0; i < top->n_fifo_decl_wrapped; i++)
+  {
+    data.n_fifos = 0;
+    if (count_top_module_node(top->fifo_decl_wrapped_trees[i], &data) < 0)
+      break;
+    n_fifos.push_back(data.n_fifos);
+  }
+  for (int i = 0; i < top->n_module_call_wrapped && (int)n_fifos.size() == top->n_fifo_decl_wrapped; i++)
+  {
+    if (count_top_module_node(top->module_call_wrapped_trees[i], &data) < 0)
+    {
+      n_fifos.clear();
+      break;
+    }
+  }
+  if ((int)n_fifos.size() != top->n_fifo_decl_wrapped ||
+      top->n_fifo_decl_wrapped != top->n_fifo_decls)
+  {
+    printf("[AutoSA] Warning: Failed to count the module instances. Skip the resource estimation.\n");
+    return isl_stat_ok;
+  }
+
+  cJSON *design_resource = cJSON_CreateObject();
+  cJSON_AddNumberToObject(design_resource, "kernel_id", gen->kernel->id);
+
+  /* modules */
+  pe_dsp = sa_estimate_pe_dsp(gen->prog, gen->kernel);
+  cJSON *modules = cJSON_CreateObject();
+  cJSON_AddItemToObject(design_resource, "modules", modules);
+  for (int i = 0; i < gen->n_hw_modules; i++)
+  {
+    struct autosa_hw_module *module = gen->hw_modules[i];
+    long bram, uram;
+    int dsp = module->type == PE_MODULE ? pe_dsp : 0;
+
+    estimate_module_memory(gen, module, &bram, &uram);
+    for (int boundary = 0; boundary <= module->boundary; boundary++)
+    {
+      std::string name(module->name);
+      if (boundary)
+        name += "_boundary";
+      long cnt = data.n_modules[name];
+      cJSON *info = cJSON_CreateObject();
+      cJSON_AddNumberToObject(info, "module_cnt", cnt);
+      cJSON_AddNumberToObject(info, "BRAM18K", bram);
+      cJSON_AddNumberToObject(info, "URAM", uram);
+      cJSON_AddNumberToObject(info, "DSP", dsp);
+      cJSON_AddItemToObject(modules, name.c_str(), info);
+      total_bram += cnt * bram;
+      total_uram += cnt * uram;
+      total_dsp += cnt * dsp;
+    }
+  }
+
+  /* fifos */
+  cJSON *fifos = cJSON_CreateObject();
+  cJSON_AddItemToObject(design_resource, "fifos", fifos);
+  for (int i = 0; i < top->n_fifo_decls; i++)
+  {
+    std::string decl_name(top->fifo_decl_names[i]);
+    size_t pos = decl_name.find('.');
+    if (pos == std::string::npos)
+      continue;
+    cJSON *info = extract_fifo_resource(n_fifos[i], atoi(decl_name.substr(pos + 1).c_str()), fifo_depth, &total_bram);
+    cJSON_AddItemToObject(fifos, decl_name.substr(0, pos).c_str(), info);
+  }
+  for (int i = 0; i < gen->n_hw_modules; i++)
+  {
+    struct autosa_hw_module *module = gen->hw_modules[i];
+    if (!module->is_serialized)
+      continue;
+    struct autosa_array_ref_group *group = module->io_groups[0];
+    std::string name = std::string(module->name) + "_serialize";
+    cJSON *info = extract_fifo_resource(1, module->data_pack_inter * group->array->size, fifo_depth, &total_bram);
+    cJSON_AddItemToObject(fifos, name.c_str(), info);
+    total_fifos++;
+  }
+  for (int i = 0; i < top->n_fifo_decls; i++)
+    total_fifos += n_fifos[i];
+  cJSON_AddNumberToObject(design_resource, "fifo_cnt", total_fifos);
+
+  printf("[AutoSA] Number of FIFOs: %ld\n", total_fifos);
+
+  cJSON_AddNumberToObject(design_resource, "BRAM18K", total_bram);
+  cJSON_AddNumberToObject(design_resource, "URAM", total_uram);
+  cJSON_AddNumberToObject(design_resource, "DSP", total_dsp);
+  usage[0] = total_dsp;
+  usage[1] = total_bram;
+  usage[2] = total_uram;
+
+  char *json_str = cJSON_Print(design_resource);
+  isl_printer *p_str = isl_printer_to_str(gen->ctx);
+  p_str = isl_printer_print_str(p_str, gen->options->autosa->output_dir);
+  p_str = isl_printer_print_str(p_str, "/resource_est/design_resource.json");
+  char *file_path = isl_printer_get_str(p_str);
+  FILE *fp = fopen(file_path, "w");
+  if (!fp)
+  {
+    printf("[AutoSA] Error: Cannot open file: %s\n", file_path);
+  }
+  else
+  {
+    fprintf(fp, "%s", json_str);
+    fclose(fp);
+  }
+  free(file_path);
+  isl_printer_free(p_str);
+  cJSON_Delete(design_resource);
+  free(json_str);
+
+  return isl_stat_ok;
+}
+
 /* Exatract the design information into a JSON struct for resource estimation.
  * If the module contains buffers, extract the buffer information.
  * For I/O modules, extract:
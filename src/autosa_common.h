@@ -178,6 +178,11 @@ struct autosa_kernel_var
   int n_part;
   /* Needs initialize */
   int init_required;
+  /* Accumulator promoted to registers */
+  int acc_reg;
+  /* Iterations of the pipelined loop between two updates of the same 
+   * accumulator register */
+  int acc_dist;
 };
 
 struct autosa_kernel
@@ -584,6 +589,8 @@ struct autosa_array_ref_group
   int copy_in;
   /* Does copy-out module exist? */
   int copy_out;
+  /* Allocate a second-level buffer at the outermost I/O module */
+  int two_level_buffer;
   /* Attached drain group */
   struct autosa_array_ref_group *attached_drain_group;  
   /* Tuning array refs */
@@ -665,6 +672,12 @@ struct autosa_local_array_info
   float compress_ratio;
   int n_meta_data;
   float eff_compress_ratio;
+
+  /* Number of SIMD lanes that keep separate partial sums inside the PE.
+   * The lanes are reduced when the local array is drained.
+   * 0 if the per-lane partial sums are not used.
+   */
+  int n_lane_partial;
 };
 
 /* "read" and "write" contain the original access relations, possibly 
@@ -854,6 +867,11 @@ struct autosa_hw_module
   /* The module uses FF to implement arrays. */
   int use_FF;
 
+  /* The outer loops of the module are infinitized and the module is 
+   * invoked as a detached TAPA task. 
+   */
+  int free_running;
+
   struct autosa_kernel *kernel;
 
   /* For Catapult HLS */
@@ -944,6 +962,16 @@ struct autosa_gen
 
   /* Tuning programs */
   std::vector<TuningProgram *> tuning_progs;
+
+  /* Indices of the distinct loop orderings found when exploring the loop 
+   * permutation. */
+  std::vector<int> loop_permute_orders;
+
+  /* BRAM18K left for the I/O buffers in the automatic buffer assignment, 
+   * negative if no budget is given. */
+  long io_bram18k_left;
+  /* Decisions of the automatic buffer assignment, dumped to tuning.json. */
+  cJSON *io_buffer_report;
 };
 
 /* Representation of special statements, in particular copy statements
@@ -1052,6 +1080,9 @@ struct autosa_kernel_stmt
     {
       struct autosa_drain_merge_func *func;
       isl_ast_expr *index;
+      /* Iterator of the innermost loop along which the array elements 
+       * are accessed contiguously, NULL if not available. */
+      char *contiguous_iter;
     } dm;
     struct
     {
@@ -1189,6 +1220,11 @@ __isl_give isl_vec *get_dep_dis_at_schedule(__isl_keep isl_basic_map *dep,
                                             __isl_keep isl_schedule *schedule);
 __isl_give isl_vec *get_dep_dis_at_node(__isl_keep isl_basic_map *dep,
                                         __isl_keep isl_schedule_node *band);
+int get_dep_dis_at_node_si(__isl_keep isl_basic_map *dep,
+                           __isl_keep isl_schedule_node *band, std::vector<long> &dis);
+void clear_dep_dis_cache();
+long autosa_pe_acc_dep_dis(struct autosa_kernel *kernel,
+                           struct autosa_array_ref_group *group);
 //__isl_give isl_schedule *loop_interchange_at_node(
 //    __isl_take isl_schedule_node *node, isl_size level1, isl_size level2);
 __isl_give isl_schedule_node *loop_interchange_at_node(
@@ -1315,9 +1351,15 @@ int read_mem_port_map(__isl_keep isl_union_map *port_map, char *name);
 /* AutoSA latency and resource estimation */
 isl_stat sa_extract_loop_info(struct autosa_gen *gen, struct autosa_hw_module *module);
 isl_stat sa_extract_array_info(struct autosa_kernel *kernel);
+int autosa_pe_acc_reg(struct autosa_kernel *kernel,
+                      struct autosa_array_ref_group *group, long n_ele);
+int autosa_local_buffer_use_reg(int acc_reg, int n_lane, long n_ele);
 int extract_memory_type(struct autosa_hw_module *module,
                         struct autosa_kernel_var *var, int uram);
 isl_stat sa_extract_design_info(struct autosa_gen *gen);
+isl_stat sa_estimate_design_resource(struct autosa_gen *gen, long *usage);
+long sa_estimate_bram18k(long width, long depth);
+int sa_estimate_pe_dsp(struct autosa_prog *prog, struct autosa_kernel *kernel);
 
 /* Tuning program */
 isl_stat TP_extract_loop_info(struct autosa_gen *gen, struct autosa_hw_module *module);
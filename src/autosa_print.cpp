@@ -316,6 +316,429 @@ __isl_give isl_printer *autosa_kernel_print_domain(__isl_take isl_printer *p,
   return pet_stmt_print_body(stmt->u.d.stmt->stmt, p, stmt->u.d.ref2expr);
 }
 
+/* Does "expr" refer to the identifier "id"?
+ */
+static int ast_expr_involves_id(__isl_keep isl_ast_expr *expr,
+                                __isl_keep isl_id *id)
+{
+  enum isl_ast_expr_type type = isl_ast_expr_get_type(expr);
+
+  if (type == isl_ast_expr_id)
+  {
+    isl_id *expr_id = isl_ast_expr_get_id(expr);
+    int involves = (expr_id == id);
+    isl_id_free(expr_id);
+    return involves;
+  }
+  if (type == isl_ast_expr_op)
+  {
+    int n_arg = isl_ast_expr_get_op_n_arg(expr);
+    for (int i = 0; i < n_arg; i++)
+    {
+      isl_ast_expr *arg = isl_ast_expr_get_op_arg(expr, i);
+      int involves = ast_expr_involves_id(arg, id);
+      isl_ast_expr_free(arg);
+      if (involves)
+        return 1;
+    }
+  }
+
+  return 0;
+}
+
+/* Extract the integer value of "expr".
+ * Return -1 if "expr" is not an integer.
+ */
+static int ast_expr_get_int(__isl_keep isl_ast_expr *expr)
+{
+  isl_val *val;
+  int v;
+
+  if (isl_ast_expr_get_type(expr) != isl_ast_expr_int)
+    return -1;
+  val = isl_ast_expr_get_val(expr);
+  v = isl_val_is_int(val) ? isl_val_get_num_si(val) : -1;
+  isl_val_free(val);
+
+  return v;
+}
+
+/* Return the AST expression of the access "expr" in "stmt".
+ * Return NULL if "expr" is not an access.
+ */
+static __isl_give isl_ast_expr *pet_access_get_ast_expr(
+  __isl_keep pet_expr *expr, struct autosa_kernel_stmt *stmt)
+{
+  isl_id *ref_id;
+  isl_ast_expr *ast_expr;
+
+  if (pet_expr_get_type(expr) != pet_expr_access)
+    return NULL;
+  ref_id = pet_expr_access_get_ref_id(expr);
+  if (!isl_id_to_ast_expr_has(stmt->u.d.ref2expr, ref_id))
+  {
+    isl_id_free(ref_id);
+    return NULL;
+  }
+  ast_expr = isl_id_to_ast_expr_get(stmt->u.d.ref2expr, ref_id);
+
+  return ast_expr;
+}
+
+/* Extract the accumulator of the user statement "stmt" if it takes the form
+ *
+ *  acc += expr;
+ *
+ * or
+ *
+ *  acc = acc + expr;
+ *
+ * Return the AST expression of the accumulator and store the name of the
+ * accessed array in "array_name".
+ * Return NULL if the statement is not an addition reduction.
+ */
+static __isl_give isl_ast_expr *extract_add_reduction_acc(
+  struct autosa_kernel_stmt *stmt, char **array_name)
+{
+  pet_tree *tree = stmt->u.d.stmt->stmt->body;
+  pet_expr *expr, *lhs, *rhs;
+  isl_ast_expr *acc = NULL;
+  enum pet_op_type op;
+
+  if (pet_tree_get_type(tree) != pet_tree_expr)
+    return NULL;
+  expr = pet_tree_expr_get_expr(tree);
+  if (pet_expr_get_type(expr) != pet_expr_op ||
+      pet_expr_get_n_arg(expr) != 2)
+  {
+    pet_expr_free(expr);
+    return NULL;
+  }
+
+  op = pet_expr_op_get_type(expr);
+  lhs = pet_expr_get_arg(expr, 0);
+  rhs = pet_expr_get_arg(expr, 1);
+  acc = pet_access_get_ast_expr(lhs, stmt);
+  if (acc && op == pet_op_assign)
+  {
+    /* The accumulator should be one of the operands of the addition. */
+    int found = 0;
+    if (pet_expr_get_type(rhs) == pet_expr_op &&
+        pet_expr_op_get_type(rhs) == pet_op_add &&
+        pet_expr_get_n_arg(rhs) == 2)
+    {
+      for (int i = 0; i < 2; i++)
+      {
+        pet_expr *arg = pet_expr_get_arg(rhs, i);
+        isl_ast_expr *arg_expr = pet_access_get_ast_expr(arg, stmt);
+        if (arg_expr && isl_ast_expr_is_equal(arg_expr, acc) == isl_bool_true)
+          found = 1;
+        isl_ast_expr_free(arg_expr);
+        pet_expr_free(arg);
+      }
+    }
+    if (!found)
+      acc = isl_ast_expr_free(acc);
+  }
+  else if (op != pet_op_add_assign)
+  {
+    acc = isl_ast_expr_free(acc);
+  }
+
+  if (acc)
+  {
+    isl_id *id = pet_expr_access_get_id(lhs);
+    *array_name = strdup(isl_id_get_name(id));
+    isl_id_free(id);
+  }
+
+  pet_expr_free(lhs);
+  pet_expr_free(rhs);
+  pet_expr_free(expr);
+
+  return acc;
+}
+
+/* Check if the for node "node" is a SIMD loop that reduces all its lanes
+ * into a single accumulator with "+", i.e.,
+ *
+ *  for (int c = 0; c <= n_lane - 1; c += 1)
+ *    // hls_unroll
+ *    acc += f(c);
+ *
+ * where "acc" does not depend on "c".
+ * If so, fill in "info" and return isl_bool_true.
+ */
+isl_bool autosa_simd_reduce_extract(__isl_keep isl_ast_node *node,
+                                    struct autosa_prog *prog,
+                                    struct autosa_simd_reduce_info *info)
+{
+  isl_ast_node *body;
+  isl_ast_expr *expr, *arg;
+  isl_id *id;
+  struct autosa_kernel_stmt *stmt;
+  int lb, ub, inc;
+  char *array_name = NULL;
+
+  info->stmt = NULL;
+  info->iterator = NULL;
+  info->n_lane = 0;
+  info->acc = NULL;
+  info->type = NULL;
+
+  if (isl_ast_node_get_type(node) != isl_ast_node_for)
+    return isl_bool_false;
+
+  /* Skip the marks and single-statement blocks above the statement. */
+  body = isl_ast_node_for_get_body(node);
+  while (body)
+  {
+    if (isl_ast_node_get_type(body) == isl_ast_node_mark)
+    {
+      isl_ast_node *child = isl_ast_node_mark_get_node(body);
+      isl_ast_node_free(body);
+      body = child;
+    }
+    else if (isl_ast_node_get_type(body) == isl_ast_node_block)
+    {
+      isl_ast_node_list *children = isl_ast_node_block_get_children(body);
+      isl_ast_node_free(body);
+      body = NULL;
+      if (isl_ast_node_list_n_ast_node(children) == 1)
+        body = isl_ast_node_list_get_ast_node(children, 0);
+      isl_ast_node_list_free(children);
+    }
+    else
+    {
+      break;
+    }
+  }
+  if (!body || isl_ast_node_get_type(body) != isl_ast_node_user)
+  {
+    isl_ast_node_free(body);
+    return isl_bool_false;
+  }
+  id = isl_ast_node_get_annotation(body);
+  isl_ast_node_free(body);
+  if (!id)
+    return isl_bool_false;
+  stmt = (struct autosa_kernel_stmt *)isl_id_get_user(id);
+  isl_id_free(id);
+  if (!stmt || stmt->type != AUTOSA_KERNEL_STMT_DOMAIN)
+    return isl_bool_false;
+
+  /* Extract the constant loop bounds. */
+  expr = isl_ast_node_for_get_init(node);
+  lb = ast_expr_get_int(expr);
+  isl_ast_expr_free(expr);
+  expr = isl_ast_node_for_get_inc(node);
+  inc = ast_expr_get_int(expr);
+  isl_ast_expr_free(expr);
+  if (lb != 0 || inc != 1)
+    return isl_bool_false;
+  expr = isl_ast_node_for_get_cond(node);
+  ub = -1;
+  if (isl_ast_expr_get_type(expr) == isl_ast_expr_op &&
+      (isl_ast_expr_get_op_type(expr) == isl_ast_op_le ||
+       isl_ast_expr_get_op_type(expr) == isl_ast_op_lt))
+  {
+    arg = isl_ast_expr_get_op_arg(expr, 1);
+    ub = ast_expr_get_int(arg);
+    isl_ast_expr_free(arg);
+    if (ub >= 0 && isl_ast_expr_get_op_type(expr) == isl_ast_op_lt)
+      ub--;
+  }
+  isl_ast_expr_free(expr);
+  if (ub < 1)
+    return isl_bool_false;
+
+  info->acc = extract_add_reduction_acc(stmt, &array_name);
+  if (!info->acc)
+    return isl_bool_false;
+
+  expr = isl_ast_node_for_get_iterator(node);
+  info->iterator = isl_ast_expr_get_id(expr);
+  isl_ast_expr_free(expr);
+  if (ast_expr_involves_id(info->acc, info->iterator))
+  {
+    free(array_name);
+    autosa_simd_reduce_info_clear(info);
+    return isl_bool_false;
+  }
+
+  for (int i = 0; i < prog->n_array; i++)
+  {
+    if (!strcmp(prog->array[i].name, array_name))
+    {
+      info->type = prog->array[i].type;
+      break;
+    }
+  }
+  free(array_name);
+  if (!info->type)
+  {
+    autosa_simd_reduce_info_clear(info);
+    return isl_bool_false;
+  }
+
+  info->stmt = stmt;
+  info->n_lane = ub + 1;
+
+  return isl_bool_true;
+}
+
+void autosa_simd_reduce_info_clear(struct autosa_simd_reduce_info *info)
+{
+  isl_id_free(info->iterator);
+  isl_ast_expr_free(info->acc);
+  info->stmt = NULL;
+  info->iterator = NULL;
+  info->acc = NULL;
+  info->type = NULL;
+  info->n_lane = 0;
+}
+
+/* Return the name of the accumulator "acc" without the indices.
+ */
+char *autosa_simd_reduce_acc_name(__isl_keep isl_ast_expr *acc)
+{
+  isl_ast_expr *base;
+  isl_id *id;
+  char *name;
+
+  if (isl_ast_expr_get_type(acc) == isl_ast_expr_op &&
+      isl_ast_expr_get_op_type(acc) == isl_ast_op_access)
+    base = isl_ast_expr_get_op_arg(acc, 0);
+  else
+    base = isl_ast_expr_copy(acc);
+  if (isl_ast_expr_get_type(base) != isl_ast_expr_id)
+  {
+    isl_ast_expr_free(base);
+    return NULL;
+  }
+  id = isl_ast_expr_get_id(base);
+  name = strdup(isl_id_get_name(id));
+  isl_id_free(id);
+  isl_ast_expr_free(base);
+
+  return name;
+}
+
+/* Construct the expression of the lane buffer of the accumulator "acc",
+ * i.e., acc_lane[...][lane], where "..." are the indices of "acc" if 
+ * "keep_index" is set.
+ */
+__isl_give isl_ast_expr *autosa_simd_reduce_lane_expr(
+  __isl_keep isl_ast_expr *acc, __isl_take isl_ast_expr *lane, int keep_index)
+{
+  isl_ctx *ctx = isl_ast_expr_get_ctx(acc);
+  isl_ast_expr_list *indices;
+  isl_ast_expr *expr;
+  isl_id *id;
+  char *name, *lane_name;
+
+  name = autosa_simd_reduce_acc_name(acc);
+  lane_name = concat(ctx, name, "lane");
+  free(name);
+  id = isl_id_alloc(ctx, lane_name, NULL);
+  free(lane_name);
+
+  indices = isl_ast_expr_list_alloc(ctx, 0);
+  if (keep_index && isl_ast_expr_get_type(acc) == isl_ast_expr_op &&
+      isl_ast_expr_get_op_type(acc) == isl_ast_op_access)
+  {
+    int n_arg = isl_ast_expr_get_op_n_arg(acc);
+    for (int i = 1; i < n_arg; i++)
+      indices = isl_ast_expr_list_add(indices, isl_ast_expr_get_op_arg(acc, i));
+  }
+  indices = isl_ast_expr_list_add(indices, lane);
+  expr = isl_ast_expr_access(isl_ast_expr_from_id(id), indices);
+
+  return expr;
+}
+
+struct simd_reduce_remap_data {
+  isl_ast_expr *acc;
+  isl_ast_expr *lane;
+  isl_id_to_ast_expr *ref2expr;
+};
+
+static isl_stat simd_reduce_remap_ref(__isl_take isl_id *id,
+                                      __isl_take isl_ast_expr *expr, void *user)
+{
+  struct simd_reduce_remap_data *data = (struct simd_reduce_remap_data *)user;
+
+  if (isl_ast_expr_is_equal(expr, data->acc) == isl_bool_true)
+  {
+    isl_ast_expr_free(expr);
+    expr = isl_ast_expr_copy(data->lane);
+  }
+  data->ref2expr = isl_id_to_ast_expr_set(data->ref2expr, id, expr);
+
+  return isl_stat_ok;
+}
+
+/* Return a copy of "ref2expr" with all the references to "acc" replaced by
+ * "lane".
+ */
+__isl_give isl_id_to_ast_expr *autosa_simd_reduce_remap(
+  __isl_keep isl_id_to_ast_expr *ref2expr, __isl_keep isl_ast_expr *acc,
+  __isl_keep isl_ast_expr *lane)
+{
+  struct simd_reduce_remap_data data;
+  isl_ctx *ctx = isl_ast_expr_get_ctx(acc);
+
+  data.acc = acc;
+  data.lane = lane;
+  data.ref2expr = isl_id_to_ast_expr_alloc(ctx, 0);
+  isl_id_to_ast_expr_foreach(ref2expr, &simd_reduce_remap_ref, &data);
+
+  return data.ref2expr;
+}
+
+/* Print a balanced adder tree that sums up all the "lanes".
+ * The intermediate sums are named as [prefix]_sum_[level]_[id].
+ * If "stage" is positive, a register is inserted after every "stage" levels.
+ * The expression of the tree root is stored in "root".
+ */
+__isl_give isl_printer *autosa_print_reduce_tree(__isl_take isl_printer *p,
+  const char *type, const char *prefix, std::vector<std::string> lanes,
+  int stage, std::string &root)
+{
+  int level = 0;
+
+  while (lanes.size() > 1)
+  {
+    std::vector<std::string> sums;
+    level++;
+    for (int i = 0; i + 1 < lanes.size(); i += 2)
+    {
+      std::string name = std::string(prefix) + "_sum_" +
+                         std::to_string(level) + "_" + std::to_string(i / 2);
+      int reg = (stage > 0 && level % stage == 0);
+
+      p = isl_printer_start_line(p);
+      p = isl_printer_print_str(p, type);
+      p = isl_printer_print_str(p, " ");
+      p = isl_printer_print_str(p, name.c_str());
+      p = isl_printer_print_str(p, reg ? " = hls::reg(" : " = ");
+      p = isl_printer_print_str(p, lanes[i].c_str());
+      p = isl_printer_print_str(p, " + ");
+      p = isl_printer_print_str(p, lanes[i + 1].c_str());
+      p = isl_printer_print_str(p, reg ? ");" : ";");
+      p = isl_printer_end_line(p);
+      sums.push_back(name);
+    }
+    /* The odd lane is forwarded to the next level. */
+    if (lanes.size() % 2 == 1)
+      sums.push_back(lanes[lanes.size() - 1]);
+    lanes = sums;
+  }
+  root = lanes[0];
+
+  return p;
+}
+
 /* Print the declaration of a non-linearized array argument.
  */
 static __isl_give isl_printer *print_non_linearized_declaration_argument(
@@ -1935,7 +2358,9 @@ static __isl_give isl_printer *print_inst_ids_suffix(
       isl_val *val = isl_vec_get_element_val(offset, i);
       if (!isl_val_is_zero(val))
       {
-        p = isl_printer_print_str(p, " + ");
+        /* The offset is negative along the mixed-sign directions. */
+        p = isl_printer_print_str(p, isl_val_is_neg(val) ? " - " : " + ");
+        val = isl_val_abs(val);
         p = isl_printer_print_val(p, val);
       }
       isl_val_free(val);
@@ -1978,7 +2403,9 @@ static __isl_give isl_printer *print_pretrans_inst_ids_suffix(
       isl_val *val = isl_vec_get_element_val(offset, i);
       if (!isl_val_is_zero(val))
       {
-        p = isl_printer_print_str(p, " + ");
+        /* The offset is negative along the mixed-sign directions. */
+        p = isl_printer_print_str(p, isl_val_is_neg(val) ? " - " : " + ");
+        val = isl_val_abs(val);
         p = isl_printer_print_val(p, val);
       }
       isl_val_free(val);
@@ -2405,8 +2832,13 @@ __isl_give isl_printer *print_module_call_upper(__isl_take isl_printer *p,
   p = isl_printer_print_str(p, "p = isl_printer_start_line(p);");
   p = isl_printer_end_line(p);
 
-  if (target == TAPA_HW)
-    p = print_str_new_line(p, "p = isl_printer_print_str(p, \".invoke(\");");
+  if (target == TAPA_HW) {
+    /* Free-running modules are detached from the top task. */
+    if (!dummy && module->free_running)
+      p = print_str_new_line(p, "p = isl_printer_print_str(p, \".invoke<tapa::detach>(\");");
+    else
+      p = print_str_new_line(p, "p = isl_printer_print_str(p, \".invoke(\");");
+  }
 
   p = isl_printer_start_line(p);
   p = isl_printer_print_str(p, "p = isl_printer_print_str(p, \"");
@@ -3207,6 +3639,49 @@ __isl_give isl_printer *print_fifo_rw_tapa(
   return p;
 }
 
+/* Print the code that aligns the decoded positions of the sparse group "n" 
+ * to the group boundary before the mask of the group is decoded, i.e.,
+ *
+ *  pos = n * NON_ZERO_NUM;
+ *  for (int m = 0; m < NON_ZERO_NUM; m++)
+ *    index[pos + m] = n * VEC_LEN;
+ *
+ * Groups packed from the CSR/CSC format may hold fewer than NON_ZERO_NUM 
+ * elements. Without the alignment, the positions of all the following groups 
+ * would be shifted. The padded slots point to the first element of the group, 
+ * which is multiplied by the zero padding of the sparse array.
+ */
+static __isl_give isl_printer *print_sparse_index_align(
+  __isl_take isl_printer *p, struct autosa_kernel *kernel, struct hls_info *hls)
+{
+  p = isl_printer_start_line(p);
+  p = isl_printer_print_str(p, "pos = n * ");
+  p = isl_printer_print_int(p, kernel->n_nzero);
+  p = isl_printer_print_str(p, ";");
+  p = isl_printer_end_line(p);
+  if (hls->target == CATAPULT_HW) {
+    p = print_str_new_line(p, "#pragma unroll yes");
+  }
+  p = isl_printer_start_line(p);
+  p = isl_printer_print_str(p, "for (int m = 0; m < ");
+  p = isl_printer_print_int(p, kernel->n_nzero);
+  p = isl_printer_print_str(p, "; m++) {");
+  p = isl_printer_end_line(p);
+  if (hls->target == XILINX_HW || hls->target == TAPA_HW) {
+    p = print_str_new_line(p, "#pragma HLS UNROLL");
+  }
+  p = isl_printer_indent(p, 2);
+  p = isl_printer_start_line(p);
+  p = isl_printer_print_str(p, "index[pos + m] = n * ");
+  p = isl_printer_print_int(p, kernel->vec_len);
+  p = isl_printer_print_str(p, ";");
+  p = isl_printer_end_line(p);
+  p = isl_printer_indent(p, -2);
+  p = print_str_new_line(p, "}");
+
+  return p;
+}
+
 /* Print an I/O statement.
  *
  * An in I/O statement is printed as
@@ -3313,7 +3788,74 @@ __isl_give isl_printer *autosa_kernel_print_io(__isl_take isl_printer *p,
     local_index_packed = isl_ast_expr_set_op_arg(local_index_packed, n_arg - 1, arg);
   }
 
-  if (data_pack == nxt_data_pack && !group->local_array->is_sparse)
+  if (module->type == PE_MODULE && !stmt->u.i.in &&
+      stmt->u.i.local_array->n_lane_partial > 0)
+  {
+    /* Reduce the per-lane partial sums before draining out the data.
+     *
+     * {
+     *   [type] local_lane_sum_1_0 = local_lane[...][0] + local_lane[...][1];
+     *   ...
+     *   fifo.write(local[] + local_lane_sum_n_0);
+     *   local_lane[...][0] = 0;
+     *   ...
+     * }
+     */
+    int n_lane = stmt->u.i.local_array->n_lane_partial;
+    std::vector<std::string> lanes;
+    std::string root;
+    char *acc_name, *lane_name;
+
+    if (data_pack != 1 || nxt_data_pack != 1 || is_sparse)
+      throw std::runtime_error(
+        "[AutoSA] Error: SIMD lane partial sums are not supported with data packing or sparsity.");
+
+    acc_name = autosa_simd_reduce_acc_name(local_index_packed);
+    for (int l = 0; l < n_lane; l++)
+    {
+      isl_ast_expr *lane = autosa_simd_reduce_lane_expr(local_index_packed,
+                             isl_ast_expr_from_val(isl_val_int_from_si(ctx, l)), 1);
+      isl_printer *p_str = isl_printer_to_str(ctx);
+      p_str = isl_printer_set_output_format(p_str, ISL_FORMAT_C);
+      p_str = isl_printer_print_ast_expr(p_str, lane);
+      char *lane_str = isl_printer_get_str(p_str);
+      lanes.push_back(std::string(lane_str));
+      free(lane_str);
+      isl_printer_free(p_str);
+      isl_ast_expr_free(lane);
+    }
+
+    lane_name = concat(ctx, acc_name, "lane");
+    p = ppcg_start_block(p);
+    p = autosa_print_reduce_tree(p, group->array->type, lane_name, lanes,
+          module->options->autosa->simd_reduce_tree_stage, root);
+    p = isl_printer_start_line(p);
+    if (hls->target == XILINX_HW)
+      p = print_fifo_rw_xilinx(p, fifo_name, 0);
+    else if (hls->target == TAPA_HW)
+      p = print_fifo_rw_tapa(p, fifo_name, 0);
+    else if (hls->target == INTEL_HW)
+      p = print_fifo_rw_intel(p, fifo_name, 0);
+    else if (hls->target == CATAPULT_HW)
+      p = print_fifo_rw_catapult(p, fifo_name, 0);
+    p = isl_printer_print_ast_expr(p, local_index_packed);
+    p = isl_printer_print_str(p, " + ");
+    p = isl_printer_print_str(p, root.c_str());
+    p = isl_printer_print_str(p, ");");
+    p = isl_printer_end_line(p);
+    for (int l = 0; l < n_lane; l++)
+    {
+      p = isl_printer_start_line(p);
+      p = isl_printer_print_str(p, lanes[l].c_str());
+      p = isl_printer_print_str(p, " = 0;");
+      p = isl_printer_end_line(p);
+    }
+    p = ppcg_end_block(p);
+
+    free(acc_name);
+    free(lane_name);
+  }
+  else if (data_pack == nxt_data_pack && !group->local_array->is_sparse)
   {
     // TODO: modify the sparse
 
@@ -3765,6 +4307,7 @@ __isl_give isl_printer *autosa_kernel_print_io(__isl_take isl_printer *p,
         }
 
         p = isl_printer_indent(p, 2);        
+        p = print_sparse_index_align(p, kernel, hls);
         p = print_str_new_line(p, "unsigned char offset = s_tmp.i(7, 0);");
         p = print_str_new_line(p, "s_tmp.i = s_tmp.i >> 8;");
         
@@ -5431,6 +5974,34 @@ static __isl_give isl_printer *io_transfer_read_data_split(
   return p;
 }
 
+/* Return the name of the stall flag if the I/O transfer statement "stmt" 
+ * is printed in the non-blocking FIFO mode, NULL otherwise.
+ * The non-blocking FIFO mode is only applied to the inter_trans and 
+ * intra_trans steps of the double buffered modules printed in the while-loop 
+ * style on Xilinx and TAPA.
+ */
+static const char *io_transfer_non_block_stall(
+  struct autosa_kernel_stmt *stmt, struct hls_info *hls, 
+  const char *iterator_prefix)
+{
+  struct autosa_hw_module *module = stmt->u.i.module;
+
+  if (!module->options->autosa->non_block_fifo)
+    return NULL;
+  if (hls->target != XILINX_HW && hls->target != TAPA_HW)
+    return NULL;
+  if (!module->double_buffer || 
+      module->options->autosa->double_buffer_style != 0 ||
+      !iterator_prefix)
+    return NULL;
+  if (!strcmp(iterator_prefix, "inter_c"))
+    return "inter_stall";
+  if (!strcmp(iterator_prefix, "intra_c"))
+    return "intra_stall";
+
+  return NULL;
+}
+
 static __isl_give isl_printer *autosa_kernel_print_io_transfer(
   __isl_take isl_printer *p, struct autosa_kernel_stmt *stmt,  
   struct hls_info *hls, const char *iterator_prefix, 
@@ -5481,6 +6052,45 @@ static __isl_give isl_printer *autosa_kernel_print_io_transfer(
 
   p = ppcg_start_block(p);  
 
+  /* In the non-blocking FIFO mode, the transfer is only performed when 
+   * all the FIFOs it accesses are ready. Otherwise, the step is stalled
+   * and retried in the next iteration.
+   *
+   * if (!fifo_in.empty() && !fifo_out.full()) {
+   *   ...
+   * } else {
+   *   [inter|intra]_stall = 1;
+   * }
+   */
+  const char *stall = io_transfer_non_block_stall(stmt, hls, iterator_prefix);
+  if (stall && (in == FIFO || out == FIFO)) {
+    char *fifo_name;
+
+    p = isl_printer_start_line(p);
+    p = isl_printer_print_str(p, "if (");
+    if (in == FIFO) {
+      fifo_name = concat(ctx, stmt->u.i.in_fifo_name, in_fifo_suffix);
+      p = isl_printer_print_str(p, "!");
+      p = isl_printer_print_str(p, fifo_name);
+      p = isl_printer_print_str(p, ".empty()");
+      free(fifo_name);
+    }
+    if (out == FIFO) {
+      fifo_name = concat(ctx, stmt->u.i.out_fifo_name, out_fifo_suffix);
+      if (in == FIFO)
+        p = isl_printer_print_str(p, " && ");
+      p = isl_printer_print_str(p, "!");
+      p = isl_printer_print_str(p, fifo_name);
+      p = isl_printer_print_str(p, ".full()");
+      free(fifo_name);
+    }
+    p = isl_printer_print_str(p, ") {");
+    p = isl_printer_end_line(p);
+    p = isl_printer_indent(p, 2);
+  } else {
+    stall = NULL;
+  }
+
   /* Declare some common variables here. */  
   int in_n_lane, out_n_lane;
   if (module->in) {    
@@ -5817,6 +6427,18 @@ static __isl_give isl_printer *autosa_kernel_print_io_transfer(
     }
   }
 
+  if (stall) {
+    p = isl_printer_indent(p, -2);
+    p = print_str_new_line(p, "} else {");
+    p = isl_printer_indent(p, 2);
+    p = isl_printer_start_line(p);
+    p = isl_printer_print_str(p, stall);
+    p = isl_printer_print_str(p, " = 1;");
+    p = isl_printer_end_line(p);
+    p = isl_printer_indent(p, -2);
+    p = print_str_new_line(p, "}");
+  }
+
   p = ppcg_end_block(p);
 
   isl_ast_expr_free(local_index_packed);
@@ -6703,66 +7325,170 @@ __isl_give isl_printer *autosa_kernel_print_host_serialize(
   return p;
 }
 
-/* Print a drain merge statement.
- *
- * [group_array_prefix]_to[...] = [group_array_prefix]_from[...]
+/* Replace the array name in the drain merge index "index" by
+ * [group_array_prefix][suffix].
  */
-__isl_give isl_printer *autosa_kernel_print_drain_merge(__isl_take isl_printer *p,
-                                                        struct autosa_kernel_stmt *stmt, struct hls_info *hls)
+static __isl_give isl_ast_expr *drain_merge_index(isl_ctx *ctx,
+                                                  __isl_keep isl_ast_expr *index, const char *suffix)
 {
-  isl_ast_expr *index_to, *index_from, *arg;
-  isl_ctx *ctx = hls->ctx;
-  struct autosa_drain_merge_func *func = stmt->u.dm.func;
-  isl_ast_expr *index = stmt->u.dm.index;
-  int n_arg;
+  isl_ast_expr *arg;
   isl_id *id;
   const char *array_name;
   char *new_array_name;
   isl_printer *p_str;
 
-  p = isl_printer_start_line(p);
-  // TODO
-  n_arg = isl_ast_expr_get_op_n_arg(index);
-  /* Modify the index. */
   arg = isl_ast_expr_get_op_arg(index, 0);
   id = isl_ast_expr_id_get_id(arg);
   array_name = isl_id_get_name(id);
-  isl_id_free(id);
-  isl_ast_expr_free(arg);
   p_str = isl_printer_to_str(ctx);
   p_str = isl_printer_print_str(p_str, array_name);
-  p_str = isl_printer_print_str(p_str, "_to");
+  p_str = isl_printer_print_str(p_str, suffix);
   new_array_name = isl_printer_get_str(p_str);
   isl_printer_free(p_str);
-  id = isl_id_alloc(ctx, new_array_name, NULL);
-  arg = isl_ast_expr_from_id(id);
-  free(new_array_name);
-  index_to = isl_ast_expr_set_op_arg(isl_ast_expr_copy(index), 0, arg);
-
-  arg = isl_ast_expr_get_op_arg(index, 0);
-  id = isl_ast_expr_id_get_id(arg);
-  array_name = isl_id_get_name(id);
   isl_id_free(id);
   isl_ast_expr_free(arg);
-  p_str = isl_printer_to_str(ctx);
-  p_str = isl_printer_print_str(p_str, array_name);
-  p_str = isl_printer_print_str(p_str, "_from");
-  new_array_name = isl_printer_get_str(p_str);
-  isl_printer_free(p_str);
   id = isl_id_alloc(ctx, new_array_name, NULL);
   arg = isl_ast_expr_from_id(id);
   free(new_array_name);
-  index_from = isl_ast_expr_set_op_arg(isl_ast_expr_copy(index), 0, arg);
 
+  return isl_ast_expr_set_op_arg(isl_ast_expr_copy(index), 0, arg);
+}
+
+/* Print a drain merge statement.
+ *
+ * [group_array_prefix]_to[...] = [group_array_prefix]_from[...]
+ */
+__isl_give isl_printer *autosa_kernel_print_drain_merge(__isl_take isl_printer *p,
+                                                        struct autosa_kernel_stmt *stmt, struct hls_info *hls)
+{
+  isl_ast_expr *index_to, *index_from;
+  isl_ctx *ctx = hls->ctx;
+  isl_ast_expr *index = stmt->u.dm.index;
+
+  index_to = drain_merge_index(ctx, index, "_to");
+  index_from = drain_merge_index(ctx, index, "_from");
+
+  p = isl_printer_start_line(p);
   p = isl_printer_print_ast_expr(p, index_to);
   p = isl_printer_print_str(p, " = ");
   p = isl_printer_print_ast_expr(p, index_from);
   p = isl_printer_print_str(p, ";");
+  p = isl_printer_end_line(p);
 
   isl_ast_expr_free(index_to);
   isl_ast_expr_free(index_from);
 
+  return p;
+}
+
+/* Print the innermost loop "node" of the drain merge function as a single
+ * memcpy if the loop walks the array contiguously with the unit stride.
+ *
+ * {
+ *   int c = lb;
+ *   memcpy(&[group_array_prefix]_to[...], &[group_array_prefix]_from[...],
+ *          (ub - c + 1) * sizeof(type));
+ * }
+ *
+ * Otherwise, print the loop as it is.
+ */
+static __isl_give isl_printer *print_for_drain_merge(__isl_take isl_printer *p,
+                                                     __isl_take isl_ast_print_options *print_options,
+                                                     __isl_keep isl_ast_node *node, void *user)
+{
+  struct hls_info *hls = (struct hls_info *)user;
+  isl_ast_node *body;
+  isl_ast_expr *iter, *init, *cond, *inc, *ub;
+  isl_val *inc_val;
+  isl_id *id;
+  struct autosa_kernel_stmt *stmt = NULL;
+  enum isl_ast_op_type cond_type;
+  isl_ast_expr *index_to, *index_from;
+  int contiguous;
+
+  body = isl_ast_node_for_get_body(node);
+  if (isl_ast_node_get_type(body) == isl_ast_node_user)
+  {
+    id = isl_ast_node_get_annotation(body);
+    if (id)
+      stmt = (struct autosa_kernel_stmt *)isl_id_get_user(id);
+    isl_id_free(id);
+  }
+  isl_ast_node_free(body);
+  if (!stmt || stmt->type != AUTOSA_KERNEL_STMT_DRAIN_MERGE ||
+      !stmt->u.dm.contiguous_iter ||
+      isl_ast_node_for_is_degenerate(node) != isl_bool_false)
+    return isl_ast_node_for_print(node, p, print_options);
+
+  iter = isl_ast_node_for_get_iterator(node);
+  id = isl_ast_expr_get_id(iter);
+  contiguous = !strcmp(isl_id_get_name(id), stmt->u.dm.contiguous_iter);
+
+  inc = isl_ast_node_for_get_inc(node);
+  inc_val = isl_ast_expr_get_val(inc);
+  contiguous = contiguous && inc_val && isl_val_is_one(inc_val);
+  isl_val_free(inc_val);
+  isl_ast_expr_free(inc);
+
+  cond = isl_ast_node_for_get_cond(node);
+  cond_type = isl_ast_expr_get_op_type(cond);
+  contiguous = contiguous &&
+               (cond_type == isl_ast_op_le || cond_type == isl_ast_op_lt);
+  if (contiguous)
+  {
+    isl_ast_expr *arg = isl_ast_expr_get_op_arg(cond, 0);
+    contiguous = isl_ast_expr_is_equal(arg, iter) == isl_bool_true;
+    isl_ast_expr_free(arg);
+  }
+  if (!contiguous)
+  {
+    isl_id_free(id);
+    isl_ast_expr_free(iter);
+    isl_ast_expr_free(cond);
+    return isl_ast_node_for_print(node, p, print_options);
+  }
+  isl_ast_print_options_free(print_options);
+
+  init = isl_ast_node_for_get_init(node);
+  p = print_str_new_line(p, "{");
+  p = isl_printer_indent(p, 2);
+  p = isl_printer_start_line(p);
+  p = isl_printer_print_str(p, isl_options_get_ast_iterator_type(hls->ctx));
+  p = isl_printer_print_str(p, " ");
+  p = isl_printer_print_str(p, isl_id_get_name(id));
+  p = isl_printer_print_str(p, " = ");
+  p = isl_printer_print_ast_expr(p, init);
+  p = isl_printer_print_str(p, ";");
+  p = isl_printer_end_line(p);
+  isl_ast_expr_free(init);
+
+  index_to = drain_merge_index(hls->ctx, stmt->u.dm.index, "_to");
+  index_from = drain_merge_index(hls->ctx, stmt->u.dm.index, "_from");
+  ub = isl_ast_expr_get_op_arg(cond, 1);
+  p = isl_printer_start_line(p);
+  p = isl_printer_print_str(p, "memcpy(&");
+  p = isl_printer_print_ast_expr(p, index_to);
+  p = isl_printer_print_str(p, ", &");
+  p = isl_printer_print_ast_expr(p, index_from);
+  p = isl_printer_print_str(p, ", (");
+  p = isl_printer_print_ast_expr(p, ub);
+  p = isl_printer_print_str(p, " - ");
+  p = isl_printer_print_str(p, isl_id_get_name(id));
+  if (cond_type == isl_ast_op_le)
+    p = isl_printer_print_str(p, " + 1");
+  p = isl_printer_print_str(p, ") * sizeof(");
+  p = isl_printer_print_str(p, stmt->u.dm.func->group->local_array->array->type);
+  p = isl_printer_print_str(p, "));");
   p = isl_printer_end_line(p);
+  p = isl_printer_indent(p, -2);
+  p = print_str_new_line(p, "}");
+
+  isl_id_free(id);
+  isl_ast_expr_free(ub);
+  isl_ast_expr_free(index_to);
+  isl_ast_expr_free(index_from);
+  isl_ast_expr_free(iter);
+  isl_ast_expr_free(cond);
 
   return p;
 }
@@ -8212,6 +8938,173 @@ isl_stat print_sparse_macros(struct autosa_kernel *kernel, struct hls_info *hls)
   return isl_stat_ok;
 }
 
+/* Print the helper function that packs the sparse array "local_array" 
+ * from the CSR/CSC format into the block sparse layout streamed by the 
+ * L3 I/O module.
+ * The non-zero elements are grouped by every VEC_LEN elements along the last 
+ * dimension of the array. Each group is stored as 
+ * [data x NON_ZERO_NUM, mask, padding], where the bits in the mask indicate 
+ * the positions of the non-zero elements inside the group. Groups with fewer 
+ * than NON_ZERO_NUM elements are padded with zeros, which are skipped by the 
+ * PEs without affecting the results.
+ * The functions are fixed-ratio converters: every group occupies the same 
+ * NON_ZERO_NUM slots as in the stream consumed by the PEs. 
+ * If any group holds more than NON_ZERO_NUM elements, the function reports 
+ * the block and returns -1 so that the host can pick a larger block sparse 
+ * ratio. Otherwise, 0 is returned.
+ * The mask is stored in one byte, the same as the offsets decoded by the PEs,
+ * which is checked statically against VEC_LEN.
+ *
+ * For CSR, "ptr" indexes the rows and "idx" stores the column indices. 
+ * For CSC, "ptr" indexes the columns and "idx" stores the row indices.
+ */
+static __isl_give isl_printer *print_sparse_pack_func(
+  __isl_take isl_printer *p, struct autosa_local_array_info *local_array, 
+  int format, struct hls_info *hls)
+{
+  const char *type = local_array->array->type;
+  const char *name = local_array->array->name;
+  int csr = format == AUTOSA_SPARSE_FORMAT_CSR;
+
+  p = print_str_new_line(p, "/* Helper Function */");
+  p = isl_printer_start_line(p);
+  if (hls->hls)
+    p = isl_printer_print_str(p, "inline ");
+  p = isl_printer_print_str(p, "int ");
+  p = isl_printer_print_str(p, name);
+  p = isl_printer_print_str(p, csr? "_pack_csr(" : "_pack_csc(");
+  p = isl_printer_print_str(p, "const int *ptr, const int *idx, const ");
+  p = isl_printer_print_str(p, type);
+  p = isl_printer_print_str(p, " *val, int n_row, int n_col, ");
+  p = isl_printer_print_str(p, type);
+  p = isl_printer_print_str(p, " *");
+  p = isl_printer_print_str(p, name);
+  p = isl_printer_print_str(p, "_s){");
+  p = isl_printer_end_line(p);
+  p = isl_printer_indent(p, 2);
+
+  p = print_str_new_line(p, "static_assert(VEC_LEN <= 8, \"The mask of each block holds at most 8 elements.\");");
+  p = print_str_new_line(p, "/* Variable Declaration */");
+  p = print_str_new_line(p, "int n_block = n_col / VEC_LEN;");
+  p = print_str_new_line(p, "int block_size = NON_ZERO_NUM + META_DATA_NUM;");
+  p = print_str_new_line(p, "/* Variable Declaration */");
+  p = isl_printer_end_line(p);
+
+  p = print_str_new_line(p, "if (n_col % VEC_LEN != 0) {");
+  p = isl_printer_indent(p, 2);
+  p = isl_printer_start_line(p);
+  p = isl_printer_print_str(p, "fprintf(stderr, \"[");
+  p = isl_printer_print_str(p, name);
+  p = isl_printer_print_str(p, csr? "_pack_csr" : "_pack_csc");
+  p = isl_printer_print_str(p, "] Error: the number of columns %d is not a multiple of %d.\\n\", n_col, VEC_LEN);");
+  p = isl_printer_end_line(p);
+  p = print_str_new_line(p, "return -1;");
+  p = isl_printer_indent(p, -2);
+  p = print_str_new_line(p, "}");
+  p = print_str_new_line(p, "for (int n = 0; n < n_row * n_block * block_size; n++)");
+  p = isl_printer_start_line(p);
+  p = isl_printer_print_str(p, "  ");
+  p = isl_printer_print_str(p, name);
+  p = isl_printer_print_str(p, "_s[n] = 0;");
+  p = isl_printer_end_line(p);
+
+  p = print_str_new_line(p, csr? "for (int r = 0; r < n_row; r++) {" :
+                                 "for (int c = 0; c < n_col; c++) {");
+  p = isl_printer_indent(p, 2);
+  p = print_str_new_line(p, csr? "for (int e = ptr[r]; e < ptr[r + 1]; e++) {" :
+                                 "for (int e = ptr[c]; e < ptr[c + 1]; e++) {");
+  p = isl_printer_indent(p, 2);
+  p = print_str_new_line(p, csr? "int r_idx = r, c_idx = idx[e];" :
+                                 "int r_idx = idx[e], c_idx = c;");
+  p = isl_printer_start_line(p);
+  p = isl_printer_print_str(p, type);
+  p = isl_printer_print_str(p, " *block = ");
+  p = isl_printer_print_str(p, name);
+  p = isl_printer_print_str(p, "_s + (r_idx * n_block + c_idx / VEC_LEN) * block_size;");
+  p = isl_printer_end_line(p);
+  p = print_str_new_line(p, "int pos = c_idx % VEC_LEN;");
+  p = isl_printer_start_line(p);
+  p = isl_printer_print_str(p, "union {");
+  p = isl_printer_print_str(p, type);
+  p = isl_printer_print_str(p, " d; unsigned char c;} u;");
+  p = isl_printer_end_line(p);
+  p = print_str_new_line(p, "u.d = block[NON_ZERO_NUM];");
+  p = print_str_new_line(p, "unsigned char mask = u.c;");
+  p = print_str_new_line(p, "int cnt = 0, n = 0;");
+  p = print_str_new_line(p, "for (int m = 0; m < VEC_LEN; m++) {");
+  p = print_str_new_line(p, "  cnt += (mask >> m) & 1;");
+  p = print_str_new_line(p, "  n += (m < pos) ? ((mask >> m) & 1) : 0;");
+  p = print_str_new_line(p, "}");
+  p = print_str_new_line(p, "if (cnt == NON_ZERO_NUM) {");
+  p = isl_printer_indent(p, 2);
+  p = isl_printer_start_line(p);
+  p = isl_printer_print_str(p, "fprintf(stderr, \"[");
+  p = isl_printer_print_str(p, name);
+  p = isl_printer_print_str(p, csr? "_pack_csr" : "_pack_csc");
+  p = isl_printer_print_str(p, "] Error: block (row %d, columns %d-%d) has more than %d non-zero elements.\\n\", r_idx, c_idx / VEC_LEN * VEC_LEN, c_idx / VEC_LEN * VEC_LEN + VEC_LEN - 1, NON_ZERO_NUM);");
+  p = isl_printer_end_line(p);
+  p = print_str_new_line(p, "return -1;");
+  p = isl_printer_indent(p, -2);
+  p = print_str_new_line(p, "}");
+  p = print_str_new_line(p, "/* Keep the elements sorted by their positions in the group. */");
+  p = print_str_new_line(p, "for (int m = cnt; m > n; m--)");
+  p = print_str_new_line(p, "  block[m] = block[m - 1];");
+  p = print_str_new_line(p, "block[n] = val[e];");
+  p = print_str_new_line(p, "u.c = mask | (1 << pos);");
+  p = print_str_new_line(p, "block[NON_ZERO_NUM] = u.d;");
+  p = isl_printer_indent(p, -2);
+  p = print_str_new_line(p, "}");
+  p = isl_printer_indent(p, -2);
+  p = print_str_new_line(p, "}");
+  p = print_str_new_line(p, "return 0;");
+
+  p = isl_printer_indent(p, -2);
+  p = print_str_new_line(p, "}");
+  p = print_str_new_line(p, "/* Helper Function */");
+  p = isl_printer_end_line(p);
+
+  return p;
+}
+
+/* Print the helper functions that pack the sparse arrays from the 
+ * host-side dense and CSR/CSC formats into the block sparse format.
+ */
+isl_stat print_sparse_pack_funcs(struct autosa_kernel *kernel, struct hls_info *hls)
+{
+  isl_printer *p;
+  int format = kernel->options->autosa->block_sparse_format;
+
+  if (format == AUTOSA_SPARSE_FORMAT_DENSE)
+    return isl_stat_ok;
+  if (kernel->vec_len > 8) {
+    printf("[AutoSA] Error: The CSR/CSC packing functions support the group vector length up to 8, as the mask of each block is 8 bits. The packing functions are not generated.\n");
+    return isl_stat_error;
+  }
+
+  if (!hls->hls)
+    p = isl_printer_to_file(kernel->ctx, hls->host_h);
+  else
+    p = isl_printer_to_file(kernel->ctx, hls->kernel_h);
+  p = isl_printer_set_output_format(p, ISL_FORMAT_C);
+  /* The packing functions report the overflowing groups. */
+  p = print_str_new_line(p, "#include <cstdio>");
+  p = isl_printer_end_line(p);
+  for (int i = 0; i < kernel->n_array; i++) {
+    struct autosa_local_array_info *local_array = &kernel->array[i];
+    if (!local_array->is_sparse)
+      continue;
+    if (local_array->array->n_index != 2) {
+      printf("[AutoSA] Warning: Only 2D sparse arrays can be packed from the CSR/CSC format. Skip the array %s.\n", 
+             local_array->array->name);
+      continue;
+    }
+    p = print_sparse_pack_func(p, local_array, format, hls);
+  }
+  isl_printer_free(p);
+
+  return isl_stat_ok;
+}
+
 /* Print the arguments to a drain merge function declaration or call.
  * If "types" is set, then print a declaration (including the types of the arguments).
  * 
@@ -8410,6 +9303,9 @@ isl_stat print_drain_merge_funcs(
     print_options = isl_ast_print_options_alloc(ctx);
     print_options = isl_ast_print_options_set_print_user(print_options,
                                                          &print_module_stmt, &hw_data);
+    if (kernel->options->autosa->fast_drain_merge)
+      print_options = isl_ast_print_options_set_print_for(print_options,
+                                                          &print_for_drain_merge, hls);
     p = isl_ast_node_print(funcs[i]->device_tree, p, print_options);
 
     p = isl_printer_indent(p, -2);
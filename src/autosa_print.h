@@ -2,6 +2,10 @@
 #define _AUTOSA_PRINT_H
 
 #include <isl/printer.h>
+#include <isl/ast.h>
+#include <isl/id_to_ast_expr.h>
+#include <string>
+#include <vector>
 
 #include "autosa_common.h"
 
@@ -111,6 +115,33 @@ __isl_give isl_printer *autosa_kernel_print_fifo_decl(
 /* Statements */
 __isl_give isl_printer *autosa_kernel_print_domain(__isl_take isl_printer *p,
                                                    struct autosa_kernel_stmt *stmt);
+
+/* SIMD reductions */
+struct autosa_simd_reduce_info
+{
+  /* The reduction statement. */
+  struct autosa_kernel_stmt *stmt;
+  /* The SIMD loop iterator. */
+  isl_id *iterator;
+  int n_lane;
+  /* The AST expression of the accumulator. */
+  isl_ast_expr *acc;
+  /* Element type of the accumulator. */
+  char *type;
+};
+isl_bool autosa_simd_reduce_extract(__isl_keep isl_ast_node *node,
+                                    struct autosa_prog *prog,
+                                    struct autosa_simd_reduce_info *info);
+void autosa_simd_reduce_info_clear(struct autosa_simd_reduce_info *info);
+char *autosa_simd_reduce_acc_name(__isl_keep isl_ast_expr *acc);
+__isl_give isl_ast_expr *autosa_simd_reduce_lane_expr(
+  __isl_keep isl_ast_expr *acc, __isl_take isl_ast_expr *lane, int keep_index);
+__isl_give isl_id_to_ast_expr *autosa_simd_reduce_remap(
+  __isl_keep isl_id_to_ast_expr *ref2expr, __isl_keep isl_ast_expr *acc,
+  __isl_keep isl_ast_expr *lane);
+__isl_give isl_printer *autosa_print_reduce_tree(__isl_take isl_printer *p,
+  const char *type, const char *prefix, std::vector<std::string> lanes,
+  int stage, std::string &root);
 __isl_give isl_printer *autosa_kernel_print_io(__isl_take isl_printer *p,
                                                struct autosa_kernel_stmt *stmt, struct hls_info *hls);
 __isl_give isl_printer *autosa_kernel_print_io_transfer(
@@ -177,6 +208,7 @@ __isl_give isl_printer *print_fifo_rw_tapa(__isl_take isl_printer *p,
 
 /* Sparse */
 isl_stat print_sparse_macros(struct autosa_kernel *kernel, struct hls_info *hls);
+isl_stat print_sparse_pack_funcs(struct autosa_kernel *kernel, struct hls_info *hls);
 
 /* Host functions */
 __isl_give isl_printer *print_drain_merge_arguments(
@@ -3,6 +3,9 @@
 #include <isl/ctx.h>
 #include <isl/schedule_node.h>
 
+#include <string>
+#include <unordered_map>
+
 #include "autosa_common.h"
 #include "autosa_utils.h"
 #include "autosa_schedule_tree.h"
@@ -480,19 +483,58 @@ __isl_give isl_vec *get_dep_dis_at_schedule(__isl_keep isl_basic_map *dep,
   return dep_dis;
 }
 
-/* Compute the dependence distance vector of the dependence under the 
- * partial schedule of the band node. The dependence "dep" is untagged.
+/* A cached dependence distance vector.
+ * "ret" is 0 if the distance vector is an integer vector, in which case
+ * "num" holds its elements, and -1 otherwise.
+ * "num" and "den" hold the numerators and denominators of the rational
+ * elements, with a zero denominator marking the non-rational elements
+ * (rebuilt as NaN), so that "get_dep_dis_at_node" can rebuild the
+ * non-integer vectors without recomputing them.
  */
-__isl_give isl_vec *get_dep_dis_at_node(__isl_keep isl_basic_map *dep, __isl_keep isl_schedule_node *band)
+struct dep_dis_cache_entry {
+  int ret;
+  std::vector<long> num;
+  std::vector<long> den;
+};
+
+/* Cache of the dependence distance vectors.
+ * The key is composed of the dependence and the partial schedule of the band
+ * (with the subtree contraction applied), so that any change of the schedule
+ * leads to a new entry. The printed form is used as the key, since building
+ * the isl hashes requires converting the partial schedule into a union map,
+ * which is more expensive than printing it.
+ * The results of "is_dep_carried_by_node" are cached in "dep_carried_cache".
+ * Both caches are cleared at the start and the end of each kernel.
+ */
+static std::unordered_map<std::string, dep_dis_cache_entry> dep_dis_cache;
+static std::unordered_map<std::string, int> dep_carried_cache;
+
+/* Clear the caches of the dependence distance vectors. */
+void clear_dep_dis_cache()
 {
-  if (isl_schedule_node_get_type(band) != isl_schedule_node_band)
-    return NULL;
+  dep_dis_cache.clear();
+  dep_carried_cache.clear();
+}
 
-  isl_multi_union_pw_aff *p_sc = isl_schedule_node_band_get_partial_schedule(band);
-  isl_union_pw_multi_aff *contraction = isl_schedule_node_get_subtree_contraction(band);
-  p_sc = isl_multi_union_pw_aff_pullback_union_pw_multi_aff(p_sc, contraction);
+static std::string dep_dis_cache_key(__isl_keep isl_basic_map *dep,
+                                     __isl_keep isl_multi_union_pw_aff *p_sc)
+{
+  char *dep_str = isl_basic_map_to_str(dep);
+  char *p_sc_str = isl_multi_union_pw_aff_to_str(p_sc);
+  std::string key = std::string(dep_str) + "|" + std::string(p_sc_str);
+  free(dep_str);
+  free(p_sc_str);
 
-  int band_w = isl_schedule_node_band_n_member(band);
+  return key;
+}
+
+/* Compute the dependence distance vector of the dependence "dep" under the 
+ * partial schedule "p_sc".
+ */
+static __isl_give isl_vec *compute_dep_dis_at_node(__isl_keep isl_basic_map *dep,
+                                                   __isl_take isl_multi_union_pw_aff *p_sc)
+{
+  int band_w = isl_multi_union_pw_aff_dim(p_sc, isl_dim_set);
   isl_vec *dep_dis = isl_vec_zero(isl_basic_map_get_ctx(dep), band_w);
   for (int i = 0; i < band_w; i++)
   {
@@ -581,6 +623,262 @@ __isl_give isl_vec *get_dep_dis_at_node(__isl_keep isl_basic_map *dep, __isl_kee
   return dep_dis;
 }
 
+/* Look up the dependence distance vector of the dependence "dep" under the
+ * partial schedule of the band node in "dep_dis_cache".
+ * The vector is computed and cached if it is not found, including the
+ * non-integer ones.
+ */
+static const dep_dis_cache_entry &lookup_dep_dis_at_node(
+  __isl_keep isl_basic_map *dep, __isl_keep isl_schedule_node *band)
+{
+  isl_multi_union_pw_aff *p_sc = isl_schedule_node_band_get_partial_schedule(band);
+  isl_union_pw_multi_aff *contraction = isl_schedule_node_get_subtree_contraction(band);
+  p_sc = isl_multi_union_pw_aff_pullback_union_pw_multi_aff(p_sc, contraction);
+
+  std::string key = dep_dis_cache_key(dep, p_sc);
+  auto it = dep_dis_cache.find(key);
+  if (it != dep_dis_cache.end()) {
+    isl_multi_union_pw_aff_free(p_sc);
+    return it->second;
+  }
+
+  dep_dis_cache_entry entry;
+  entry.ret = 0;
+  isl_vec *dep_dis = compute_dep_dis_at_node(dep, p_sc);
+  for (int i = 0; i < isl_vec_size(dep_dis); i++) {
+    isl_val *val = isl_vec_get_element_val(dep_dis, i);
+    if (isl_val_is_rat(val)) {
+      entry.num.push_back(isl_val_get_num_si(val));
+      entry.den.push_back(isl_val_get_den_si(val));
+    } else {
+      entry.num.push_back(0);
+      entry.den.push_back(0);
+    }
+    if (!isl_val_is_int(val))
+      entry.ret = -1;
+    isl_val_free(val);
+  }
+  isl_vec_free(dep_dis);
+
+  return dep_dis_cache[key] = entry;
+}
+
+/* Compute the dependence distance vector of the dependence "dep" under the 
+ * partial schedule of the band node, and store it in "dis".
+ * The results are memoized in "dep_dis_cache".
+ * Return -1 if "band" is not a band node or the distance is not an integer 
+ * vector, and 0 otherwise.
+ */
+int get_dep_dis_at_node_si(__isl_keep isl_basic_map *dep,
+                           __isl_keep isl_schedule_node *band, std::vector<long> &dis)
+{
+  if (isl_schedule_node_get_type(band) != isl_schedule_node_band)
+    return -1;
+
+  const dep_dis_cache_entry &entry = lookup_dep_dis_at_node(dep, band);
+  if (entry.ret < 0)
+    return -1;
+  dis = entry.num;
+
+  return 0;
+}
+
+/* Compute the dependence distance vector of the dependence under the 
+ * partial schedule of the band node. The dependence "dep" is untagged.
+ */
+__isl_give isl_vec *get_dep_dis_at_node(__isl_keep isl_basic_map *dep, __isl_keep isl_schedule_node *band)
+{
+  if (isl_schedule_node_get_type(band) != isl_schedule_node_band)
+    return NULL;
+
+  const dep_dis_cache_entry &entry = lookup_dep_dis_at_node(dep, band);
+  isl_ctx *ctx = isl_basic_map_get_ctx(dep);
+  isl_vec *dep_dis = isl_vec_zero(ctx, entry.num.size());
+  for (int i = 0; i < entry.num.size(); i++) {
+    isl_val *val;
+    if (entry.den[i] == 0)
+      val = isl_val_nan(ctx);
+    else
+      val = isl_val_div(isl_val_int_from_si(ctx, entry.num[i]),
+                        isl_val_int_from_si(ctx, entry.den[i]));
+    dep_dis = isl_vec_set_element_val(dep_dis, i, val);
+  }
+
+  return dep_dis;
+}
+
+/* Return isl_bool_true if "set" does not have the tuple identifier "user". */
+static isl_bool set_not_has_tuple_id(__isl_keep isl_set *set, void *user)
+{
+  isl_id *id = (isl_id *)user;
+  isl_id *set_id = isl_set_get_tuple_id(set);
+  isl_bool not_has = set_id != id ? isl_bool_true : isl_bool_false;
+
+  isl_id_free(set_id);
+  return not_has;
+}
+
+/* Compute the distance of the untagged dependence "dep" of the statement 
+ * "stmt_id" in the iterations of the pipelined loops, i.e., the time loops 
+ * from the "array" mark down to the "hls_pipeline" (or "simd") mark in the 
+ * kernel schedule, which are executed one iteration per cycle.
+ * The distance vector at these loops is linearized by the loop bounds.
+ * Return -1 if the distance is not a positive integer.
+ */
+static long get_dep_dis_at_pipeline(struct autosa_kernel *kernel,
+                                    __isl_keep isl_basic_map *dep, __isl_keep isl_id *stmt_id)
+{
+  isl_schedule_node *node;
+  std::vector<long> dis, ubs;
+  long lin_dis = 0, stride = 1;
+
+  node = isl_schedule_get_root(kernel->schedule);
+  node = autosa_tree_move_down_to_array(node, kernel->core);
+  while (node && isl_schedule_node_get_type(node) != isl_schedule_node_leaf)
+  {
+    enum isl_schedule_node_type type = isl_schedule_node_get_type(node);
+    /* The loops below are unrolled. */
+    if (is_marked(node, "hls_pipeline") || is_marked(node, "simd"))
+      break;
+    if (type == isl_schedule_node_band)
+    {
+      std::vector<long> band_dis;
+      int n = isl_schedule_node_band_n_member(node);
+      int *band_ubs;
+      if (get_dep_dis_at_node_si(dep, node, band_dis) < 0)
+      {
+        isl_schedule_node_free(node);
+        return -1;
+      }
+      band_ubs = extract_band_upper_bounds(node);
+      for (int i = 0; i < n; i++)
+      {
+        if (isl_schedule_node_band_member_get_space_time(node, i) == autosa_loop_time)
+        {
+          dis.push_back(band_dis[i]);
+          ubs.push_back(band_ubs[i]);
+        }
+      }
+      free(band_ubs);
+    }
+    else if (type == isl_schedule_node_sequence || type == isl_schedule_node_set)
+    {
+      /* Follow the child that executes the statement. */
+      int n = isl_schedule_node_n_children(node);
+      int i;
+      for (i = 0; i < n; i++)
+      {
+        isl_schedule_node *child = isl_schedule_node_get_child(node, i);
+        isl_union_set *filter = isl_schedule_node_filter_get_filter(child);
+        filter = isl_union_set_preimage_union_pw_multi_aff(filter,
+                   isl_schedule_node_get_subtree_contraction(child));
+        int found = isl_union_set_every_set(filter, &set_not_has_tuple_id,
+                                            stmt_id) == isl_bool_false;
+        isl_union_set_free(filter);
+        isl_schedule_node_free(child);
+        if (found)
+          break;
+      }
+      if (i == n)
+      {
+        isl_schedule_node_free(node);
+        return -1;
+      }
+      node = isl_schedule_node_child(node, i);
+    }
+    node = isl_schedule_node_child(node, 0);
+  }
+  isl_schedule_node_free(node);
+
+  for (int i = (int)dis.size() - 1; i >= 0; i--)
+  {
+    lin_dis += dis[i] * stride;
+    stride *= ubs[i];
+  }
+
+  return lin_dis > 0 ? lin_dis : -1;
+}
+
+/* Internal data used in autosa_pe_acc_dep_dis. */
+struct autosa_pe_acc_dep_dis_data
+{
+  struct autosa_kernel *kernel;
+  struct autosa_array_ref_group *group;
+  long dis;
+};
+
+/* Update the minimal distance in "user" with the RAW dependence "map" if it 
+ * is an accumulation, i.e., a dependence from a statement to itself, in the 
+ * kernel and on a reference of the group (any reference if the group is 
+ * not set).
+ */
+static isl_bool update_pe_acc_dep_dis(__isl_keep isl_map *map, void *user)
+{
+  struct autosa_pe_acc_dep_dis_data *data = (struct autosa_pe_acc_dep_dis_data *)user;
+  isl_basic_map_list *bmap_list = isl_map_get_basic_map_list(map);
+  isl_space *space = isl_map_get_space(map);
+  isl_space *src_space = isl_space_unwrap(isl_space_domain(isl_space_copy(space)));
+  isl_space *dest_space = isl_space_unwrap(isl_space_range(space));
+  isl_id *src_stmt = isl_space_get_tuple_id(src_space, isl_dim_in);
+  isl_id *dest_stmt = isl_space_get_tuple_id(dest_space, isl_dim_in);
+  isl_id *src_ref = isl_space_get_tuple_id(src_space, isl_dim_out);
+  isl_id *dest_ref = isl_space_get_tuple_id(dest_space, isl_dim_out);
+  int is_acc = src_stmt == dest_stmt;
+
+  isl_space_free(src_space);
+  isl_space_free(dest_space);
+  if (is_acc)
+    is_acc = isl_union_set_every_set(data->kernel->core, &set_not_has_tuple_id,
+                                     src_stmt) == isl_bool_false;
+  if (is_acc && data->group)
+  {
+    is_acc = 0;
+    for (int i = 0; i < data->group->n_ref; i++)
+    {
+      if (data->group->refs[i]->ref_id == src_ref || 
+          data->group->refs[i]->ref_id == dest_ref)
+        is_acc = 1;
+    }
+  }
+  for (int i = 0; is_acc && i < isl_map_n_basic_map(map); i++)
+  {
+    isl_basic_map *dep = isl_basic_map_list_get_basic_map(bmap_list, i);
+    isl_basic_map *untagged_dep = isl_basic_map_from_map(
+        isl_map_factor_domain(isl_map_from_basic_map(dep)));
+    long dis = get_dep_dis_at_pipeline(data->kernel, untagged_dep, src_stmt);
+    if (dis > 0 && (data->dis < 0 || dis < data->dis))
+      data->dis = dis;
+    isl_basic_map_free(untagged_dep);
+  }
+  isl_basic_map_list_free(bmap_list);
+  isl_id_free(src_stmt);
+  isl_id_free(dest_stmt);
+  isl_id_free(src_ref);
+  isl_id_free(dest_ref);
+
+  return isl_bool_true;
+}
+
+/* Compute the distance of the accumulation in the PEs of "kernel" from the 
+ * RAW dependences, in the iterations of the pipelined loops. 
+ * Only the accumulations on the references of "group" are considered if 
+ * "group" is set. Return the minimal distance, or -1 if no accumulation 
+ * is carried by the pipelined loops.
+ */
+long autosa_pe_acc_dep_dis(struct autosa_kernel *kernel,
+                           struct autosa_array_ref_group *group)
+{
+  struct autosa_pe_acc_dep_dis_data data = {kernel, group, -1};
+
+  if (!kernel->schedule || !kernel->core)
+    return -1;
+  if (isl_union_map_every_map(kernel->scop->tagged_dep_flow,
+                              &update_pe_acc_dep_dis, &data) < 0)
+    return -1;
+
+  return data.dis;
+}
+
 /* Interchange the loop at "level1" and "level2" in the schedule node and 
  * return the new schedule. */
 __isl_give isl_schedule_node *loop_interchange_at_node(
@@ -1230,12 +1528,21 @@ int is_dep_carried_by_node(__isl_keep isl_basic_map *dep, __isl_keep isl_schedul
   isl_map *map_dep, *test;
   int is_carried;
 
+  /* Look up the cache first. */
+  isl_multi_union_pw_aff *p_sc = isl_schedule_node_band_get_partial_schedule(node);
+  std::string key = dep_dis_cache_key(dep, p_sc);
+  isl_multi_union_pw_aff_free(p_sc);
+  auto it = dep_carried_cache.find(key);
+  if (it != dep_carried_cache.end())
+    return it->second;
+
   umap = isl_schedule_node_band_get_partial_schedule_union_map(node);
   umap_dep = isl_union_map_from_map(isl_map_factor_domain(isl_map_from_basic_map(isl_basic_map_copy(dep))));
   umap_dep = isl_union_map_apply_range(umap_dep, isl_union_map_copy(umap));
   umap_dep = isl_union_map_apply_domain(umap_dep, umap);
   if (isl_union_map_is_empty(umap_dep)) {
     isl_union_map_free(umap_dep);
+    dep_carried_cache[key] = -1;
     return -1;
   }
   map_dep = isl_map_from_union_map(umap_dep);
@@ -1244,6 +1551,7 @@ int is_dep_carried_by_node(__isl_keep isl_basic_map *dep, __isl_keep isl_schedul
   is_carried = !isl_map_is_subset(map_dep, test);
   isl_map_free(map_dep);
   isl_map_free(test);
+  dep_carried_cache[key] = is_carried;
   
   return is_carried;
 }
@@ -2187,14 +2495,26 @@ static __isl_give isl_schedule *determine_properties_original_schedule(
 
 /* Compute a schedule or determine the properties of the original schedule
  * depending on the value of the "reschedule" option.
+ * If the scheduler exceeds the ISL operation budget, we fall back to 
+ * the original schedule.
  */
 static __isl_give isl_schedule *compute_or_set_properties(void *user)
 {
   struct autosa_gen *gen = (struct autosa_gen *)user;
 
-  if (gen->options->reschedule)
-    return compute_schedule(gen);
-  else
+  if (gen->options->reschedule) {
+    isl_schedule *schedule;
+
+    autosa_isl_budget_start(gen->ctx, gen->options);
+    schedule = compute_schedule(gen);
+    if (autosa_isl_budget_stop(gen->ctx) || !schedule) {
+      isl_schedule_free(schedule);
+      autosa_report_degradation(gen->options, "scheduling",
+                                "Use the original schedule instead.");
+      return determine_properties_original_schedule(gen);
+    }
+    return schedule;
+  } else
     return determine_properties_original_schedule(gen);
 }
 
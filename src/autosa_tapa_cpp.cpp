@@ -37,7 +37,8 @@ static void print_tapa_host_header(FILE *fp)
 /* Open the host .cpp file and the kernel .h and .cpp files for writing.
  * Add the necessary includes.
  */
-static void hls_open_files(struct hls_info *info, const char *input)
+static void hls_open_files(struct hls_info *info, const char *input,
+                           struct ppcg_options *options)
 {
   char name[PATH_MAX];
   char dir[PATH_MAX];
@@ -74,6 +75,9 @@ static void hls_open_files(struct hls_info *info, const char *input)
           "inline T1 max(T1 x, T2 y) { return (x > T1(y)) ? x : T1(y); }\n");
   fprintf(info->host_h, "\n");
   print_tapa_host_header(info->host_h);
+  if (options->autosa->fast_drain_merge)
+    /* memcpy is used to merge the drained data. */
+    fprintf(info->host_h, "\n#include <cstring>\n");
   fprintf(info->host_c, "#include \"%s\"\n", name);
 
   strcpy(name + len, "_kernel_modules.cpp");
@@ -1270,6 +1274,33 @@ static __isl_give isl_printer *print_for_with_unroll(
   return p;
 }
 
+/* Print the infinitized loop.
+ * The first infinitized loop is replaced by a "while (1)" loop, and the rest 
+ * of the infinitized loops in the same band are removed.
+ */
+static __isl_give isl_printer *print_for_infinitize(
+    __isl_keep isl_ast_node *node, __isl_take isl_printer *p,
+    __isl_take isl_ast_print_options *print_options, int is_first)
+{
+  isl_ast_node *body;
+
+  if (is_first) {
+    p = print_str_new_line(p, "while (1) {");
+    p = isl_printer_indent(p, 2);
+  }
+
+  body = isl_ast_node_for_get_body(node);
+  p = isl_ast_node_print(body, p, print_options);
+  isl_ast_node_free(body);
+
+  if (is_first) {
+    p = isl_printer_indent(p, -2);
+    p = print_str_new_line(p, "}");
+  }
+
+  return p;
+}
+
 static __isl_give isl_printer *print_for_tapa(__isl_take isl_printer *p,
                                                 __isl_take isl_ast_print_options *print_options,
                                                 __isl_keep isl_ast_node *node, void *user)
@@ -1277,9 +1308,13 @@ static __isl_give isl_printer *print_for_tapa(__isl_take isl_printer *p,
   isl_id *id;
   int pipeline;
   int unroll;
+  int infinitize, is_first_infinitize;
+  struct print_hw_module_data *hw_data = (struct print_hw_module_data *)user;
 
   pipeline = 0;
   unroll = 0;
+  infinitize = 0;
+  is_first_infinitize = 0;
   id = isl_ast_node_get_annotation(node);
 
   if (id)
@@ -1291,9 +1326,16 @@ static __isl_give isl_printer *print_for_tapa(__isl_take isl_printer *p,
       pipeline = 1;
     if (info && info->is_unroll)
       unroll = 1;
+    if (info && info->is_infinitize_legal && hw_data->module &&
+        hw_data->module->free_running) {
+      infinitize = 1;
+      is_first_infinitize = info->is_first_infinitizable_loop;
+    }
   }
 
-  if (pipeline)
+  if (infinitize)
+    p = print_for_infinitize(node, p, print_options, is_first_infinitize);
+  else if (pipeline)
     p = print_for_with_pipeline(node, p, print_options);
   else if (unroll)
     p = print_for_with_unroll(node, p, print_options);
@@ -2426,6 +2468,7 @@ static __isl_give isl_printer *print_double_buffer_module_while(
   }
 
   struct print_db_module_while_data print_data;
+  int non_block = module->options->autosa->non_block_fifo;
 
   /* Extract the code snippets. */
   extract_double_buffer_module_while_data(module, boundary, &print_data);
@@ -2453,9 +2496,16 @@ static __isl_give isl_printer *print_double_buffer_module_while(
   /* Print inter_trans */
   p = print_str_new_line(p, "if (inter_trans_en) {");
   p = isl_printer_indent(p, 2);
+  if (non_block)
+    p = print_str_new_line(p, "bool inter_stall = 0;");
   /* Print the module logic */
   p = autosa_print_inter_trans_module_double_buffer(p, module, prog, hls, boundary);
   /* Print the loop counter */
+  if (non_block) {
+    /* Only advance the loop counter if the transfer is not stalled. */
+    p = print_str_new_line(p, "if (!inter_stall) {");
+    p = isl_printer_indent(p, 2);
+  }
   for (int i = 0; i < print_data.inter_for_logic.size(); i++) {
     p = isl_printer_start_line(p);
     p = isl_printer_print_str(p, print_data.inter_for_logic[i]);
@@ -2468,6 +2518,10 @@ static __isl_give isl_printer *print_double_buffer_module_while(
     p = isl_printer_indent(p, -2);
     p = print_str_new_line(p, "}");
   }
+  if (non_block) {
+    p = isl_printer_indent(p, -2);
+    p = print_str_new_line(p, "}");
+  }
 
   p = isl_printer_indent(p, -2);
   p = print_str_new_line(p, "}");
@@ -2475,9 +2529,16 @@ static __isl_give isl_printer *print_double_buffer_module_while(
   /* Print intra_trans */
   p = print_str_new_line(p, "if (intra_trans_en) {");
   p = isl_printer_indent(p, 2);
+  if (non_block)
+    p = print_str_new_line(p, "bool intra_stall = 0;");
   /* Print the module logic */
   p = autosa_print_intra_trans_module_double_buffer(p, module, prog, hls, boundary);
   /* Print the loop counter */
+  if (non_block) {
+    /* Only advance the loop counter if the transfer is not stalled. */
+    p = print_str_new_line(p, "if (!intra_stall) {");
+    p = isl_printer_indent(p, 2);
+  }
   for (int i = 0; i < print_data.intra_for_logic.size(); i++) {
     p = isl_printer_start_line(p);
     p = isl_printer_print_str(p, print_data.intra_for_logic[i]);
@@ -2490,6 +2551,10 @@ static __isl_give isl_printer *print_double_buffer_module_while(
     p = isl_printer_indent(p, -2);
     p = print_str_new_line(p, "}");
   }
+  if (non_block) {
+    p = isl_printer_indent(p, -2);
+    p = print_str_new_line(p, "}");
+  }
 
   p = isl_printer_indent(p, -2);
   p = print_str_new_line(p, "}");
@@ -2558,6 +2623,7 @@ static __isl_give isl_printer *autosa_print_host_code(__isl_take isl_printer *p,
   /* Print the macros for sparse data structure */
   if (prog->scop->options->autosa->block_sparse) {
     print_sparse_macros(top->kernel, hls);
+    print_sparse_pack_funcs(top->kernel, hls);
   }
 
   /* Print the helper functions in the program. */
@@ -3122,7 +3188,7 @@ int generate_autosa_tapa_cpp(isl_ctx *ctx, struct ppcg_options *options,
   hls.hcl = false;
   hls.ctx = ctx;
   hls.output_dir = options->autosa->output_dir;
-  hls_open_files(&hls, input);
+  hls_open_files(&hls, input, options);
 
   r = generate_sa(ctx, input, hls.host_c, options, &print_hw, &hls);
 
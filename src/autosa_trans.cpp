@@ -82,6 +82,46 @@ static cJSON *load_tuning_config(char *config_file)
     return config;
 }
 
+/* Exclude the loops in "band" that carry any dependence in "deps" with 
+ * a distance other than 0 or 1 from the space loop candidates "is_space_loop".
+ * For the RAR dependences ("rar" is set) with mixed-sign components, e.g.,
+ * [1, -1] on the loops r and p for cin[r + p] in CNN, the distance -1 is 
+ * allowed as well. Such data are forwarded between PEs only if all the 
+ * non-zero components are mapped to space loops (see not_carried_at_space).
+ * The distance vector of each dependence is computed once for all the
+ * band members. 
+ */
+static void exclude_space_loops(__isl_keep isl_union_map *deps,
+    __isl_keep isl_schedule_node *band, isl_size *is_space_loop, int rar)
+{
+    isl_size band_w = isl_schedule_node_band_n_member(band);
+    isl_basic_map_list *dep_list = isl_union_map_get_basic_map_list(deps);
+    isl_size ndeps = isl_union_map_n_basic_map(deps);
+
+    for (int n = 0; n < ndeps; n++)
+    {
+        isl_basic_map *dep = isl_basic_map_list_get_basic_map(dep_list, n);
+        std::vector<long> dep_dis;
+        int ret = get_dep_dis_at_node_si(dep, band, dep_dis);
+        int has_pos = 0;
+        for (int h = 0; ret >= 0 && h < band_w; h++)
+        {
+            if (dep_dis[h] > 0)
+                has_pos = 1;
+        }
+        for (int h = 0; h < band_w; h++)
+        {
+            if (ret < 0)
+                is_space_loop[h] = 0;
+            else if (!(dep_dis[h] == 1 || dep_dis[h] == 0 || 
+                       (rar && has_pos && dep_dis[h] == -1)))
+                is_space_loop[h] = 0;
+        }
+        isl_basic_map_free(dep);
+    }
+    isl_basic_map_list_free(dep_list);
+}
+
 /* Generate asyncrhonized systolic arrays with the given dimension.
  * For sync arrays, time loops are placed inside the space loops.
  * We will first select space loop candidates from the outermost loop band 
@@ -101,35 +141,11 @@ struct autosa_kernel **sa_space_time_transform_at_dim_async(
     isl_schedule_node *band = get_outermost_permutable_node(schedule);
     isl_size band_w = isl_schedule_node_band_n_member(band);
     isl_size *is_space_loop = (isl_size *)malloc(band_w * sizeof(isl_size));
-    isl_union_map *dep_flow = scop->dep_flow;
-    isl_union_map *dep_rar = scop->dep_rar;
-    isl_union_map *dep_total = isl_union_map_union(isl_union_map_copy(dep_flow),
-                                                   isl_union_map_copy(dep_rar));
-    isl_basic_map_list *deps = isl_union_map_get_basic_map_list(dep_total);
-    isl_size ndeps = isl_union_map_n_basic_map(dep_total);
 
     for (int h = 0; h < band_w; h++)
-    {
-        int n;
-        for (n = 0; n < ndeps; n++)
-        {
-            isl_basic_map *dep = isl_basic_map_list_get_basic_map(deps, n);
-            isl_vec *dep_dis = get_dep_dis_at_node(dep, band);
-            isl_val *val = isl_vec_get_element_val(dep_dis, h);
-            if (!(isl_val_is_one(val) || isl_val_is_zero(val)))
-            {
-                isl_vec_free(dep_dis);
-                isl_val_free(val);
-                isl_basic_map_free(dep);
-                break;
-            }
-
-            isl_val_free(val);
-            isl_vec_free(dep_dis);
-            isl_basic_map_free(dep);
-        }
-        is_space_loop[h] = (n == ndeps);
-    }
+        is_space_loop[h] = 1;
+    exclude_space_loops(scop->dep_flow, band, is_space_loop, 0);
+    exclude_space_loops(scop->dep_rar, band, is_space_loop, 1);
 
     /* Perform loop permutation to generate all candidates. */
     if (dim == 1)
@@ -292,8 +308,6 @@ struct autosa_kernel **sa_space_time_transform_at_dim_async(
         }
     }
 
-    isl_basic_map_list_free(deps);
-    isl_union_map_free(dep_total);
     isl_schedule_node_free(band);
     free(is_space_loop);
 
@@ -319,35 +333,11 @@ struct autosa_kernel **sa_space_time_transform_at_dim_sync(
     isl_schedule_node *band = get_innermost_permutable_node(schedule);
     isl_size band_w = isl_schedule_node_band_n_member(band);
     isl_size *is_space_loop = (isl_size *)malloc(band_w * sizeof(isl_size));
-    isl_union_map *dep_flow = scop->dep_flow;
-    isl_union_map *dep_rar = scop->dep_rar;
-    isl_union_map *dep_total = isl_union_map_union(isl_union_map_copy(dep_flow),
-                                                   isl_union_map_copy(dep_rar));
-    isl_basic_map_list *deps = isl_union_map_get_basic_map_list(dep_total);
-    isl_size ndeps = isl_union_map_n_basic_map(dep_total);
 
     for (int h = 0; h < band_w; h++)
-    {
-        int n;
-        for (n = 0; n < ndeps; n++)
-        {
-            isl_basic_map *dep = isl_basic_map_list_get_basic_map(deps, n);
-            isl_vec *dep_dis = get_dep_dis_at_node(dep, band);
-            isl_val *val = isl_vec_get_element_val(dep_dis, h);
-            if (!(isl_val_is_one(val) || isl_val_is_zero(val)))
-            {
-                isl_vec_free(dep_dis);
-                isl_val_free(val);
-                isl_basic_map_free(dep);
-                break;
-            }
-
-            isl_val_free(val);
-            isl_vec_free(dep_dis);
-            isl_basic_map_free(dep);
-        }
-        is_space_loop[h] = (n == ndeps);
-    }
+        is_space_loop[h] = 1;
+    exclude_space_loops(scop->dep_flow, band, is_space_loop, 0);
+    exclude_space_loops(scop->dep_rar, band, is_space_loop, 1);
 
     /* Perform loop permutation to generate all candidates. */
     if (dim == 1)
@@ -512,8 +502,6 @@ struct autosa_kernel **sa_space_time_transform_at_dim_sync(
         }
     }
 
-    isl_basic_map_list_free(deps);
-    isl_union_map_free(dep_total);
     isl_schedule_node_free(band);
     free(is_space_loop);
 
@@ -733,13 +721,57 @@ struct dep_space_test_internal_data
 {
     isl_vec *dirvec;
     isl_basic_map *dep;
+    int rar;
 };
 
+/* Return the number of non-zero components of the distance vector of 
+ * the dependence "dep" in the iteration domain, 
+ * or -1 if the dependence connects different statements or the distance 
+ * is not constant.
+ */
+static int dep_n_non_zero(__isl_keep isl_basic_map *dep)
+{
+    isl_space *space = isl_basic_map_get_space(dep);
+    isl_bool equal = isl_space_tuple_is_equal(space, isl_dim_in, space, isl_dim_out);
+    isl_space_free(space);
+    if (equal != isl_bool_true)
+        return -1;
+
+    isl_set *deltas = isl_set_from_basic_set(isl_basic_map_deltas(isl_basic_map_copy(dep)));
+    int n_non_zero = 0;
+    for (int i = 0; i < isl_set_dim(deltas, isl_dim_set); i++)
+    {
+        isl_val *val = isl_set_plain_get_val_if_fixed(deltas, isl_dim_set, i);
+        int is_nan = !val || isl_val_is_nan(val);
+        if (!is_nan && !isl_val_is_zero(val))
+            n_non_zero++;
+        isl_val_free(val);
+        if (is_nan)
+        {
+            n_non_zero = -1;
+            break;
+        }
+    }
+    isl_set_free(deltas);
+
+    return n_non_zero;
+}
+
 /* This function tests if the current node contains any space loop.
  * If so, test if the dependence is carried by the space loops, and update the 
  * dependence distance vector. 
  * If the dependence is carried at the space loop, return false,
  * else return true.
+ * 
+ * A RAR dependence ("rar" is set) is carried by any non-zero distance 
+ * at the space loops, including the -1 of the mixed-sign reuse vectors.
+ * However, the data are forwarded from PE to PE at the same time step, 
+ * which requires every non-zero component of the reuse vector to be 
+ * mapped to a space loop. Otherwise, e.g., [1, -1] on the loops r and p 
+ * for cin[r + p] with only r as the space loop, the data used by one PE 
+ * are not the ones required by its neighbor at the same time step. 
+ * Such a dependence is treated as not carried with the zero direction, 
+ * and the data are loaded into each PE directly.
  */
 static isl_bool not_carried_at_space(__isl_keep isl_schedule_node *node, void *user)
 {
@@ -770,19 +802,42 @@ static isl_bool not_carried_at_space(__isl_keep isl_schedule_node *node, void *u
 
     if (n_space_dim > 0)
     {
-        isl_vec *disvec = get_dep_dis_at_node(untagged_dep, node);
+        std::vector<long> disvec;
+        if (get_dep_dis_at_node_si(untagged_dep, node, disvec) < 0)
+        {
+            /* The distance is not an integer vector. The data are loaded 
+             * into each PE directly as for the dependences not carried 
+             * at the space loops. 
+             */
+            printf("[AutoSA] Warning: Non-integer dependence distance at the space loops, treated as not carried.\n");
+            data->dirvec = isl_vec_zero(isl_schedule_node_get_ctx(node), n_space_dim);
+            isl_basic_map_free(untagged_dep);
+            return isl_bool_true;
+        }
+        disvec.resize(n_dim, 0);
         isl_vec *dirvec = isl_vec_zero(isl_schedule_node_get_ctx(node), n_space_dim);
         int carried = 0;
         for (int i = 0; i < n_space_dim; i++)
         {
-            isl_val *val = isl_vec_get_element_val(disvec, space_dim_start + i);
-            dirvec = isl_vec_set_element_si(dirvec, i, isl_val_get_num_si(val));
-            if (isl_val_get_num_si(val) > 0)
+            long val = disvec[space_dim_start + i];
+            dirvec = isl_vec_set_element_si(dirvec, i, val);
+            if (val > 0 || (data->rar && val != 0))
                 carried = 1;
-            isl_val_free(val);
+        }
+        if (carried && data->rar)
+        {
+            int n_space_non_zero = 0;
+            for (int i = 0; i < n_space_dim; i++)
+                if (disvec[space_dim_start + i] != 0)
+                    n_space_non_zero++;
+            if (dep_n_non_zero(untagged_dep) > n_space_non_zero)
+            {
+                carried = 0;
+                isl_vec_free(dirvec);
+                dirvec = isl_vec_zero(isl_schedule_node_get_ctx(node), n_space_dim);
+            }
         }
         data->dirvec = dirvec;
-        isl_vec_free(disvec);
         isl_basic_map_free(untagged_dep);
         if (carried)
             return isl_bool_false;
@@ -808,7 +863,8 @@ static isl_bool sa_candidates_smart_pick_update(__isl_keep isl_map *map, void *u
     for (int i = 0; i < isl_map_n_basic_map(map); i++)
     {
         isl_basic_map *dep = isl_basic_map_list_get_basic_map(bmap_list, i);
-        struct dep_space_test_internal_data internal_data = {NULL, dep};
+        struct dep_space_test_internal_data internal_data = {NULL, dep,
+                                                             data->dep_type == AUTOSA_DEP_RAR};
         int is_carried_at_space = !isl_schedule_node_every_descendant(node,
                                                                       not_carried_at_space, &internal_data);
         if (is_carried_at_space && data->dep_type == AUTOSA_DEP_RAR)
@@ -944,6 +1000,7 @@ static struct autosa_kernel *autosa_kernel_create_local_arrays(
         kernel->array[i].compress_ratio = 0.0f;
         kernel->array[i].n_meta_data = 0;
         kernel->array[i].eff_compress_ratio = 0.0f;
+        kernel->array[i].n_lane_partial = 0;
         kernel->array[i].global = 0;
     }
 
@@ -991,7 +1048,8 @@ isl_stat data_transfer_update(__isl_keep isl_basic_map *dep, struct data_transfe
     isl_id_free(dest_id);
 
     /* Test if the dependence is carried at the space loop. */
-    struct dep_space_test_internal_data internal_data = {NULL, dep};
+    struct dep_space_test_internal_data internal_data = {NULL, dep,
+                                                         data->dep_type == AUTOSA_DEP_RAR};
     node = isl_schedule_get_root(kernel->schedule);
     int is_carried_at_space = !isl_schedule_node_every_descendant(
         node, not_carried_at_space, &internal_data);
@@ -1452,6 +1510,7 @@ isl_stat sa_array_partitioning_optimize(struct autosa_kernel *sa,
         {
             /* Disable the L2 array partitioning */
             sa->options->autosa->two_level_buffer = 0;
+            printf("[AutoSA] Warning: Two-level buffering is disabled because the second-level array partitioning is disabled.\n");
         }
     }
 
@@ -1948,6 +2007,76 @@ static __isl_give isl_schedule_node *count_latency_hiding_loop(
     return node;
 }
 
+/* Enlarge the default latency hiding tile sizes so that the latency hiding
+ * length covers the accumulation latency "acc_latency".
+ * Each time we pick a loop, starting from the last one, and increase its 
+ * tiling factor to the next divisor of the loop bound "ubs".
+ * Loops with a non-positive tiling factor are not tiled and are skipped.
+ * We stop if the latency hiding length covers the latency, or none of the 
+ * tiling factors can be increased any more.
+ */
+static void autosa_latency_cover_acc(int *tile_size, int *ubs, int tile_len,
+    int acc_latency)
+{
+    int lat_hide_len = 1;
+    int updated = 1;
+
+    for (int i = 0; i < tile_len; i++)
+        if (tile_size[i] > 0)
+            lat_hide_len *= tile_size[i];
+    while (lat_hide_len < acc_latency && updated)
+    {
+        updated = 0;
+        for (int i = tile_len - 1; i >= 0 && lat_hide_len < acc_latency; i--)
+        {
+            int size;
+            if (tile_size[i] <= 0)
+                continue;
+            for (size = tile_size[i] + 1; size < ubs[i]; size++)
+            {
+                if (ubs[i] % size == 0)
+                    break;
+            }
+            if (size >= ubs[i])
+                continue;
+            lat_hide_len = lat_hide_len / tile_size[i] * size;
+            tile_size[i] = size;
+            updated = 1;
+        }
+    }
+}
+
+/* Check if the accumulation latency is covered after latency hiding.
+ * The distance of the accumulation is computed from the RAW dependences 
+ * in the PE schedule, in the iterations of the pipelined loops 
+ * (see autosa_pe_acc_dep_dis). The element updated at one iteration is 
+ * not touched again until this many iterations later. Therefore, the 
+ * reduction loop is expected to achieve II=1 if the distance is no less 
+ * than the accumulation latency, otherwise the expected II is 
+ * ceil(acc_latency / distance).
+ * This only compares the two numbers, the II is decided by the HLS tool.
+ * The accumulators are only promoted to registers for Xilinx HLS.
+ */
+static void autosa_latency_check_acc(struct autosa_kernel *sa)
+{
+    int acc_latency = sa->options->autosa->acc_latency;
+    long dis;
+
+    if (acc_latency <= 0)
+        return;
+    if (sa->options->target != AUTOSA_TARGET_XILINX_HLS_C)
+        printf("[AutoSA] Warning: The accumulators are only promoted to registers for Xilinx HLS, --acc-latency only enlarges the latency hiding tile sizes.\n");
+    dis = autosa_pe_acc_dep_dis(sa, NULL);
+    if (dis < 0)
+        return;
+    if (dis >= acc_latency)
+        printf("[AutoSA] Accumulation dependence distance %ld covers the accumulation latency %d, the reduction loop is expected to be pipelined with II=1.\n",
+               dis, acc_latency);
+    else
+        printf("[AutoSA] Warning: Accumulation dependence distance %ld does not cover the accumulation latency %d, the reduction loop is expected to be pipelined with II=%ld. Increase the latency hiding tile sizes to achieve II=1.\n",
+               dis, acc_latency, (acc_latency + dis - 1) / dis);
+}
+
 /* Perform the latency hiding in either "Manual" or "Auto" mode.
  * We will tile each loop with a tiling factor greater than one, and place
  * the point loop as the innermost time loop. 
@@ -2028,6 +2157,9 @@ static __isl_give isl_schedule_node *autosa_latency_tile_loop(
         {
             /* Perform the latency hiding following the default policy. */
             tile_size = read_default_latency_tile_sizes(sa, tile_len);
+            if (tile_size && sa->options->autosa->acc_latency > 0)
+                autosa_latency_cover_acc(tile_size, data.ubs, tile_len,
+                                         sa->options->autosa->acc_latency);
         }
         free(data.ubs);
     }    
@@ -2150,6 +2282,7 @@ isl_stat sa_latency_hiding_optimize(struct autosa_kernel *sa, bool en, char *mod
         schedule, &clear_pe_opt_prop, NULL);
 
     sa->schedule = schedule;    
+    autosa_latency_check_acc(sa);
 
     return isl_stat_ok;
 }
@@ -3340,6 +3473,179 @@ static void localize_bounds(struct autosa_kernel *kernel)
     isl_set_free(context);
 }
 
+/* Compare the estimated usage "usage" of the resources "res_names" with the
+ * FPGA resource budget given by "hw_info". Resources missing from the budget 
+ * file and negative estimates are not checked.
+ * The estimates are not strict bounds of the final design, so the design is 
+ * not rejected. If the budget is exceeded, a warning is printed and the 
+ * estimate is recorded under the design name and "stage" in 
+ * "resource_est/budget_check.json" under the output directory.
+ * The design is named kernelX, or kernelX_Y when the loop ordering Y is 
+ * selected, so that each loop ordering is recorded on its own.
+ */
+static isl_stat sa_record_resource_budget(struct autosa_gen *gen,
+    struct autosa_kernel *sa, const char *stage, const char **res_names, 
+    long *usage, int n)
+{
+    cJSON *hw_info, *report, *design, *resource;
+    int exceeded = 0;
+    char design_name[40];
+    FILE *fp;
+    char *content;
+    std::string report_path(gen->options->autosa->output_dir);
+
+    if (!gen->options->autosa->hw_info)
+        return isl_stat_ok;
+
+    hw_info = load_tuning_config(gen->options->autosa->hw_info);
+    if (!hw_info)
+        throw std::runtime_error("[AutoSA] Error: Failed to parse the hardware resource file.");
+    resource = cJSON_CreateObject();
+    for (int i = 0; i < n; i++) {
+        cJSON *budget = cJSON_GetObjectItemCaseSensitive(hw_info, res_names[i]);
+        cJSON *info;
+        if (!cJSON_IsNumber(budget) || usage[i] < 0)
+            continue;
+        if (usage[i] <= budget->valuedouble)
+            continue;
+        printf("[AutoSA] Warning: The design may exceed the resource budget after %s (%s: %ld > %g).\n",
+               stage, res_names[i], usage[i], budget->valuedouble);
+        info = cJSON_CreateObject();
+        cJSON_AddNumberToObject(info, "estimate", usage[i]);
+        cJSON_AddNumberToObject(info, "budget", budget->valuedouble);
+        cJSON_AddItemToObject(resource, res_names[i], info);
+        exceeded = 1;
+    }
+    cJSON_Delete(hw_info);
+    if (!exceeded) {
+        cJSON_Delete(resource);
+        return isl_stat_ok;
+    }
+
+    if (gen->options->autosa->loop_permute_order >= 0)
+        snprintf(design_name, sizeof(design_name), "kernel%d_%d", 
+                 sa->space_time_id, gen->options->autosa->loop_permute_order);
+    else
+        snprintf(design_name, sizeof(design_name), "kernel%d", sa->space_time_id);
+
+    report_path += "/resource_est/budget_check.json";
+    report = NULL;
+    fp = fopen(report_path.c_str(), "r");
+    if (fp) {
+        fclose(fp);
+        report = load_tuning_config((char *)report_path.c_str());
+    }
+    if (!report)
+        report = cJSON_CreateObject();
+    design = cJSON_GetObjectItemCaseSensitive(report, design_name);
+    if (!design) {
+        design = cJSON_CreateObject();
+        cJSON_AddItemToObject(report, design_name, design);
+    }
+    cJSON_DeleteItemFromObjectCaseSensitive(design, stage);
+    cJSON_AddItemToObject(design, stage, resource);
+
+    fp = fopen(report_path.c_str(), "w");
+    if (fp) {
+        content = cJSON_Print(report);
+        fprintf(fp, "%s", content);
+        fclose(fp);
+        free(content);
+    }
+    cJSON_Delete(report);
+
+    return isl_stat_ok;
+}
+
+/* Check the design against the FPGA resource budget given by "hw_info" 
+ * before the code generation.
+ * The DSPs are estimated from the number of PEs and the SIMD factor.
+ * If "buffer" is set, the local buffers inside PEs are estimated as well,
+ * with the memory type decided the same way as in the code generation.
+ * PE buffers never use URAM, and I/O modules and fifos are not counted 
+ * until the code generation (see sa_estimate_design_resource).
+ */
+static isl_stat sa_check_resource_budget(struct autosa_kernel *sa,
+    struct autosa_gen *gen, const char *stage, int buffer)
+{
+    const char *res_names[3] = {"DSP", "BRAM18K", "URAM"};
+    long usage[3] = {0, -1, 0};
+    long n_pe = 1;
+
+    if (!gen->options->autosa->hw_info)
+        return isl_stat_ok;
+    for (int i = 0; i < sa->n_sa_dim; i++) {
+        if (sa->sa_dim[i] <= 0)
+            return isl_stat_ok;
+        n_pe *= sa->sa_dim[i];
+    }
+
+    usage[0] = n_pe * sa_estimate_pe_dsp(gen->prog, sa);
+    if (buffer)
+        usage[1] = sa_estimate_pe_buffer_bram18k(sa);
+
+    return sa_record_resource_budget(gen, sa, stage, res_names, usage, 3);
+}
+
+/* Prepare the automatic I/O buffer assignment. The BRAM18K budget is 
+ * taken from "hw_info" if given.
+ */
+static void sa_io_buffer_assign_init(struct autosa_gen *gen)
+{
+    cJSON_Delete(gen->io_buffer_report);
+    gen->io_buffer_report = cJSON_CreateObject();
+    gen->io_bram18k_left = -1;
+    if (gen->options->autosa->hw_info) {
+        cJSON *hw_info, *budget;
+
+        hw_info = load_tuning_config(gen->options->autosa->hw_info);
+        if (!hw_info)
+            throw std::runtime_error("[AutoSA] Error: Failed to parse the hardware resource file.");
+        budget = cJSON_GetObjectItemCaseSensitive(hw_info, "BRAM18K");
+        if (cJSON_IsNumber(budget))
+            gen->io_bram18k_left = (long)budget->valuedouble;
+        cJSON_Delete(hw_info);
+    }
+    if (gen->io_bram18k_left < 0)
+        printf("[AutoSA] Warning: No BRAM18K budget is given by --hw-info, the I/O buffers are assigned by the estimated latency only.\n");
+}
+
+/* Add the decisions of the automatic I/O buffer assignment to 
+ * "tuning.json" under the output directory.
+ */
+static isl_stat sa_io_buffer_assign_dump(struct autosa_gen *gen)
+{
+    cJSON *tuning = NULL;
+    FILE *fp;
+    char *content;
+    std::string tuning_path(gen->options->autosa->output_dir);
+
+    tuning_path += "/tuning.json";
+    fp = fopen(tuning_path.c_str(), "r");
+    if (fp) {
+        fclose(fp);
+        tuning = load_tuning_config((char *)tuning_path.c_str());
+    }
+    if (!tuning)
+        tuning = cJSON_CreateObject();
+    if (gen->io_bram18k_left >= 0)
+        cJSON_AddNumberToObject(gen->io_buffer_report, "BRAM18K_left", gen->io_bram18k_left);
+    cJSON_DeleteItemFromObjectCaseSensitive(tuning, "io_buffer");
+    cJSON_AddItemToObject(tuning, "io_buffer", gen->io_buffer_report);
+    gen->io_buffer_report = NULL;
+
+    fp = fopen(tuning_path.c_str(), "w");
+    if (fp) {
+        content = cJSON_Print(tuning);
+        fprintf(fp, "%s", content);
+        fclose(fp);
+        free(content);
+    }
+    cJSON_Delete(tuning);
+
+    return isl_stat_ok;
+}
+
 /* Apply communication management including:
  * - data allocation
  * - I/O construction
@@ -3355,7 +3661,10 @@ isl_stat comm_management(struct autosa_kernel *sa, struct autosa_gen *gen)
 {
     printf("[AutoSA] Apply communication management.\n");
 
+    if (gen->options->autosa->auto_buffer_assign)
+        sa_io_buffer_assign_init(gen);
     sa_io_construct_optimize(sa, gen);
+    sa_check_resource_budget(sa, gen, "comm_management", 1);
 
     /* Localize the array bounds using parameters from the host domain. */
     localize_bounds(sa);
@@ -3515,6 +3824,7 @@ static struct autosa_kernel *optimize_single_array(struct autosa_kernel *kernel,
     /* Create the autosa_kernel object and attach to the schedule. */
     if (!kernel)    
         return NULL;    
+    sa_check_resource_budget(kernel, gen, "compute_management", 0);
 
     /* Process meta data */
     kernel = process_kernel_meta_data(kernel, gen);
@@ -3525,6 +3835,29 @@ static struct autosa_kernel *optimize_single_array(struct autosa_kernel *kernel,
     return kernel;
 }
 
+/* Add the number of legal RAR dep candidates of the array reference in "map",
+ * in the form of { kernel[] -> ref_name[n_candidates, default_candidate] },
+ * to the cJSON object "user".
+ */
+static isl_stat add_rar_dep_choice_json(__isl_take isl_map *map, void *user)
+{
+    cJSON *rar_dep_json = (cJSON *)user;
+    cJSON *ref_json = cJSON_CreateObject();
+    isl_val *n_candidates = isl_map_plain_get_val_if_fixed(map, isl_dim_out, 0);
+    isl_val *default_candidate = isl_map_plain_get_val_if_fixed(map, isl_dim_out, 1);
+
+    cJSON_AddItemToObject(ref_json, "n_candidates",
+                          cJSON_CreateNumber(isl_val_get_num_si(n_candidates)));
+    cJSON_AddItemToObject(ref_json, "default",
+                          cJSON_CreateNumber(isl_val_get_num_si(default_candidate)));
+    cJSON_AddItemToObject(rar_dep_json, isl_map_get_tuple_name(map, isl_dim_out), ref_json);
+    isl_val_free(n_candidates);
+    isl_val_free(default_candidate);
+    isl_map_free(map);
+
+    return isl_stat_ok;
+}
+
 /* Create an autosa_kernel represents the domain isntances that reach "node" and 
  * insert a mark node pointing to the autosa_kernel before "node".
  *
@@ -3625,6 +3958,18 @@ static __isl_give isl_schedule_node *compute_and_comm_optimize(
             n_sa_json = cJSON_CreateNumber(num_sa);
             cJSON_AddItemToObject(space_time_json, "n_kernel", n_sa_json);
             cJSON_AddItemToObject(tuning, "space_time", space_time_json);
+            /* Expose the RAR dep choices of the array references that 
+             * have multiple legal candidates. The choices are tuned together 
+             * with the space-time kernel id.
+             */
+            if (gen->prog->scop->rar_dep_choices &&
+                isl_union_map_n_map(gen->prog->scop->rar_dep_choices) > 0)
+            {
+                cJSON *rar_dep_json = cJSON_CreateObject();
+                isl_union_map_foreach_map(gen->prog->scop->rar_dep_choices,
+                                          &add_rar_dep_choice_json, rar_dep_json);
+                cJSON_AddItemToObject(tuning, "rar_dep", rar_dep_json);
+            }
             p_str = isl_printer_to_str(gen->ctx);
             p_str = isl_printer_print_str(p_str, gen->options->autosa->output_dir);
             p_str = isl_printer_print_str(p_str, "/tuning.json");
@@ -3642,6 +3987,8 @@ static __isl_give isl_schedule_node *compute_and_comm_optimize(
             kernel = sa_candidates_manual_pick(sa_candidates, num_sa, kernel_id);
         }
     }
+    /* The cached dependence distances of the other candidates are no longer needed. */
+    clear_dep_dis_cache();
         
     /* Dump out the intermediate code if needed */
     if (gen->options->autosa->dump_code) {
@@ -4113,6 +4460,128 @@ __isl_give isl_schedule *sa_map_to_device(struct autosa_gen *gen,
     return gen->schedule;
 }
 
+/* Map the program with the schedule "schedule" to the systolic array,
+ * and generate the code of the design.
+ * If "print_code" is not set, only the tuning information is dumped, which
+ * is used to generate the designs of the alternative loop orderings when 
+ * exploring the loop permutation.
+ */
+static __isl_give isl_printer *generate_sa_design(__isl_take isl_printer *p,
+                                                  struct autosa_gen *gen, __isl_take isl_schedule *schedule,
+                                                  struct ppcg_options *options, int print_code)
+{
+    /* Perform opt. stages:
+     * Computation Management -> Communication Management     
+     */        
+    /* The cached dependence distances are scoped to the current kernel. */
+    clear_dep_dis_cache();
+    gen->schedule = sa_map_to_device(gen, schedule);        
+
+    /* Generate the AST tree. */
+    gen->tree = sa_generate_code(gen, gen->schedule);
+    for (int i = 0; i < gen->n_hw_modules; i++)
+    {
+        if (gen->hw_modules[i]->is_filter == 1 &&
+            gen->hw_modules[i]->is_buffer == 1)
+        {
+            sa_filter_buffer_io_module_generate_code(gen, gen->hw_modules[i]);
+        }
+        else
+        {
+            sa_module_generate_code(gen, gen->hw_modules[i]);
+        }
+    }
+    sa_top_module_generate_code(gen);
+    for (int i = 0; i < gen->n_drain_merge_funcs; i++)
+    {
+        sa_drain_merge_generate_code(gen, gen->drain_merge_funcs[i]);
+    }
+    if (gen->options->autosa->host_serialize)
+    {
+        for (int i = 0; i < gen->n_hw_modules; i++)
+        {
+            if (gen->hw_modules[i]->to_mem)
+            {
+                sa_host_serialize_generate_code(gen, gen->hw_modules[i]);
+            }
+        }
+    }
+
+    /* Extract loop structure for latency estimation */
+    for (int i = 0; i < gen->n_hw_modules; i++)
+    {
+        sa_extract_loop_info(gen, gen->hw_modules[i]);
+    }
+    if (options->autosa->tuning_method == 1) {
+        /* Extract the information for performance est in the auto tuner. */
+        for (int i = 0; i < gen->n_hw_modules; i++) {     
+            TP_extract_loop_info(gen, gen->hw_modules[i]);
+            TP_extract_resource_info(gen, gen->hw_modules[i]);
+            TP_extract_module_attr(gen, gen->hw_modules[i]);
+        }        
+    }
+
+    if (print_code) {
+        const char *res_names[3] = {"DSP", "BRAM18K", "URAM"};
+        long usage[3] = {-1, -1, -1};
+
+        /* Dump out the array information */
+        sa_extract_array_info(gen->kernel);
+        /* Extract design information for resource estimation */
+        sa_extract_design_info(gen);
+        /* Check the estimate of the whole design against the budget */
+        sa_estimate_design_resource(gen, usage);
+        sa_record_resource_budget(gen, gen->kernel, "codegen", res_names, usage, 3);
+
+        /* Code generation */        
+        p = ppcg_print_exposed_declarations(p, gen->prog->scop);
+        p = gen->print(p, gen->prog, gen->tree, gen->hw_modules, gen->n_hw_modules,
+                       gen->hw_top_module, gen->drain_merge_funcs, gen->n_drain_merge_funcs,
+                       &gen->types, gen->print_user);
+    }
+
+    /* Dump the I/O buffer assignment */
+    if (gen->io_buffer_report)
+        sa_io_buffer_assign_dump(gen);
+
+    /* Dump tuning information */
+    if (options->autosa->tuning_method == 1) {
+        std::string params_f(options->autosa->output_dir);
+        params_f += "/tuning";
+        for (int i = 0; i < gen->tuning_progs.size(); i++) {
+            gen->tuning_progs[i]->dump(params_f);
+        }
+    }
+
+    /* Clean up */
+    isl_ast_node_free(gen->tree);
+    autosa_kernel_free(gen->kernel);
+    for (int i = 0; i < gen->n_hw_modules; i++)
+    {
+        autosa_hw_module_free(gen->hw_modules[i]);
+    }
+    free(gen->hw_modules);
+    autosa_hw_top_module_free(gen->hw_top_module);
+    for (int i = 0; i < gen->n_drain_merge_funcs; i++)
+    {
+        autosa_drain_merge_func_free(gen->drain_merge_funcs[i]);
+    }
+    free(gen->drain_merge_funcs);
+    gen->kernel = NULL;
+    gen->hw_modules = NULL;
+    gen->n_hw_modules = 0;
+    gen->hw_top_module = NULL;
+    gen->drain_merge_funcs = NULL;
+    gen->n_drain_merge_funcs = 0;
+    /* The tuning programs are freed together with the kernels. */
+    gen->tuning_progs.clear();
+    for (int i = 0; i < gen->prog->n_array; i++)
+        gen->prog->array[i].tuning_refs.clear();
+    clear_dep_dis_cache();
+
+    return p;
+}
+
 /* Generate HLS code for "scop" and print it to "p".
  * After generating an AST for the transformed scop as explained below,
  * we call "gen->print" to print the AST in the desired output format 
@@ -4191,7 +4660,20 @@ static __isl_give isl_printer *generate(__isl_take isl_printer *p,
      * As a temporary hack, here we will try a second time and to merge the 
      * outer band as much as possible.
      */    
+    isl_schedule *unmerged_schedule = isl_schedule_copy(schedule);
+    autosa_isl_budget_start(gen->ctx, options);
     schedule = merge_outer_bands(schedule, gen);    
+    if (autosa_isl_budget_stop(gen->ctx) || !schedule)
+    {
+        isl_schedule_free(schedule);
+        schedule = unmerged_schedule;
+        autosa_report_degradation(options, "merging outer bands",
+                                  "Use the default schedule instead.");
+    }
+    else
+    {
+        isl_schedule_free(unmerged_schedule);
+    }
     //DBGSCHD(stdout, schedule, isl_schedule_get_ctx(schedule));
 
     /* Legality check */
@@ -4213,87 +4695,33 @@ static __isl_give isl_printer *generate(__isl_take isl_printer *p,
 
         /* Perform opt. stages:
          * Computation Management -> Communication Management     
-         */        
-        gen->schedule = sa_map_to_device(gen, schedule);        
-
-        /* Generate the AST tree. */
-        gen->tree = sa_generate_code(gen, gen->schedule);
-        for (int i = 0; i < gen->n_hw_modules; i++)
-        {
-            if (gen->hw_modules[i]->is_filter == 1 &&
-                gen->hw_modules[i]->is_buffer == 1)
-            {
-                sa_filter_buffer_io_module_generate_code(gen, gen->hw_modules[i]);
-            }
-            else
-            {
-                sa_module_generate_code(gen, gen->hw_modules[i]);
-            }
-        }
-        sa_top_module_generate_code(gen);
-        for (int i = 0; i < gen->n_drain_merge_funcs; i++)
-        {
-            sa_drain_merge_generate_code(gen, gen->drain_merge_funcs[i]);
-        }
-        if (gen->options->autosa->host_serialize)
+         */
+        if (options->autosa->explore_loop_permute &&
+            options->autosa->tuning_method == 1 &&
+            options->autosa->loop_permute_order < 0)
         {
-            for (int i = 0; i < gen->n_hw_modules; i++)
+            /* Generate the designs of all the loop orderings in one run.
+             * The orderings are collected when exploring the loop 
+             * permutation of the first design, which is always ordering 0. 
+             * The code is only printed for the first design.
+             */
+            std::vector<int> orders;
+            gen->loop_permute_orders.clear();
+            options->autosa->loop_permute_order = 0;
+            p = generate_sa_design(p, gen, isl_schedule_copy(schedule), options, 1);
+            orders = gen->loop_permute_orders;
+            for (int i = 1; i < orders.size(); i++)
             {
-                if (gen->hw_modules[i]->to_mem)
-                {
-                    sa_host_serialize_generate_code(gen, gen->hw_modules[i]);
-                }
+                options->autosa->loop_permute_order = orders[i];
+                p = generate_sa_design(p, gen, isl_schedule_copy(schedule), options, 0);
             }
+            options->autosa->loop_permute_order = -1;
+            isl_schedule_free(schedule);
         }
-
-        /* Extract loop structure for latency estimation */
-        for (int i = 0; i < gen->n_hw_modules; i++)
-        {
-            sa_extract_loop_info(gen, gen->hw_modules[i]);
-        }
-        if (options->autosa->tuning_method == 1) {
-            /* Extract the information for performance est in the auto tuner. */
-            for (int i = 0; i < gen->n_hw_modules; i++) {     
-                TP_extract_loop_info(gen, gen->hw_modules[i]);
-                TP_extract_resource_info(gen, gen->hw_modules[i]);
-                TP_extract_module_attr(gen, gen->hw_modules[i]);
-            }        
-        }
-
-        /* Dump out the array information */
-        sa_extract_array_info(gen->kernel);
-        /* Extract design information for resource estimation */
-        sa_extract_design_info(gen);
-
-        /* Code generation */        
-        p = ppcg_print_exposed_declarations(p, prog->scop);
-        p = gen->print(p, gen->prog, gen->tree, gen->hw_modules, gen->n_hw_modules,
-                       gen->hw_top_module, gen->drain_merge_funcs, gen->n_drain_merge_funcs,
-                       &gen->types, gen->print_user);
-
-        /* Dump tuning information */
-        if (options->autosa->tuning_method == 1) {
-            std::string params_f(options->autosa->output_dir);
-            params_f += "/tuning";
-            for (int i = 0; i < gen->tuning_progs.size(); i++) {
-                gen->tuning_progs[i]->dump(params_f);
-            }
-        }
-
-        /* Clean up */
-        isl_ast_node_free(gen->tree);
-        autosa_kernel_free(gen->kernel);
-        for (int i = 0; i < gen->n_hw_modules; i++)
-        {
-            autosa_hw_module_free(gen->hw_modules[i]);
-        }
-        free(gen->hw_modules);
-        autosa_hw_top_module_free(gen->hw_top_module);
-        for (int i = 0; i < gen->n_drain_merge_funcs; i++)
+        else
         {
-            autosa_drain_merge_func_free(gen->drain_merge_funcs[i]);
+            p = generate_sa_design(p, gen, schedule, options, 1);
         }
-        free(gen->drain_merge_funcs);
     }
 
     autosa_prog_free(prog);
@@ -4344,6 +4772,23 @@ int generate_sa(isl_ctx *ctx, const char *input, FILE *out,
     gen.schedule = NULL;
     gen.kernel = NULL;
     gen.tuning_config = NULL;    
+    gen.io_bram18k_left = -1;
+    gen.io_buffer_report = NULL;
+
+    if (options->autosa->non_block_fifo && 
+        options->autosa->double_buffer_style != 0) {
+        printf("[AutoSA] Warning: Non-blocking FIFO requires the while-loop double buffer style. Switch to double-buffer-style 0.\n");
+        options->autosa->double_buffer_style = 0;
+    }
+
+    autosa_reset_degradation_log(options);
+    if (options->autosa->hw_info)
+    {
+        /* Clear the budget records of the previous runs. */
+        std::string report_path(options->autosa->output_dir);
+        report_path += "/resource_est/budget_check.json";
+        remove(report_path.c_str());
+    }
 
     r = ppcg_transform(ctx, input, out, options, &generate_wrap, &gen);    
 
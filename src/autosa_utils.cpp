@@ -4,6 +4,7 @@
 #include <stdexcept>
 #include <limits>
 #include <cmath>
+#include <string>
 
 #include <isl/space.h>
 #include <barvinok/isl.h>
@@ -457,4 +458,66 @@ std::vector<int> get_factors(int x) {
     factors.push_back(large_factors[i]);
   }
   return factors;
-}
\ No newline at end of file
+}
+/* Start the ISL operation budget of a compilation step.
+ * The budget is set by the option "isl_max_operations", 0 for unlimited.
+ * The error state of "ctx" is cleared so that autosa_isl_budget_stop only
+ * reports the errors raised by this step.
+ */
+void autosa_isl_budget_start(isl_ctx *ctx, struct ppcg_options *options)
+{
+  isl_ctx_reset_error(ctx);
+  if (options->autosa->isl_max_operations == 0)
+    return;
+  isl_ctx_reset_operations(ctx);
+  isl_ctx_set_max_operations(ctx, options->autosa->isl_max_operations);
+}
+
+/* Stop the ISL operation budget of the current compilation step.
+ * Return isl_bool_true if the step failed, either because the budget is 
+ * exceeded or because any other ISL error is raised. In such case, the 
+ * results of the step are unreliable (possibly NULL) and the caller should 
+ * apply a fallback.
+ * The error state is cleared so that the following steps can proceed.
+ */
+isl_bool autosa_isl_budget_stop(isl_ctx *ctx)
+{
+  isl_bool failed = isl_ctx_last_error(ctx) != isl_error_none ? 
+    isl_bool_true : isl_bool_false;
+
+  if (isl_ctx_get_max_operations(ctx) != 0) {
+    isl_ctx_set_max_operations(ctx, 0);
+    isl_ctx_reset_operations(ctx);
+  }
+  if (failed)
+    isl_ctx_reset_error(ctx);
+
+  return failed;
+}
+
+/* Remove the degradation log left by the previous run in the same 
+ * output directory, so that a clean run leaves no log behind.
+ */
+void autosa_reset_degradation_log(struct ppcg_options *options)
+{
+  std::string path = std::string(options->autosa->output_dir) + "/degradation.log";
+  remove(path.c_str());
+}
+
+/* Report that the compilation step "stage" exceeds the ISL operation budget
+ * and the "fallback" is applied.
+ * The degradations of the current run are logged in 
+ * "[output_dir]/degradation.log", which is removed at the start of each run
+ * (see autosa_reset_degradation_log).
+ */
+void autosa_report_degradation(struct ppcg_options *options, const char *stage,
+                               const char *fallback)
+{
+  printf("[AutoSA] Warning: ISL operation budget exceeded in %s. %s\n", stage, fallback);
+  std::string path = std::string(options->autosa->output_dir) + "/degradation.log";
+  FILE *fp = fopen(path.c_str(), "a");
+  if (fp) {
+    fprintf(fp, "%s: %s\n", stage, fallback);
+    fclose(fp);
+  }
+}
@@ -55,6 +55,13 @@ long compute_set_max(__isl_keep isl_set *set, int dim);
 /* Get the factors of the number x. */
 std::vector<int> get_factors(int x);
 
+/* ISL operation budget */
+void autosa_isl_budget_start(isl_ctx *ctx, struct ppcg_options *options);
+isl_bool autosa_isl_budget_stop(isl_ctx *ctx);
+void autosa_reset_degradation_log(struct ppcg_options *options);
+void autosa_report_degradation(struct ppcg_options *options, const char *stage,
+                               const char *fallback);
+
 #if defined(__cplusplus)
 }
 #endif
@@ -114,7 +114,8 @@ static void print_xilinx_host_header(FILE *fp)
 /* Open the host .cpp file and the kernel .h and .cpp files for writing.
  * Add the necessary includes.
  */
-static void hls_open_files(struct hls_info *info, const char *input)
+static void hls_open_files(struct hls_info *info, const char *input,
+                           struct ppcg_options *options)
 {
   char name[PATH_MAX];
   char dir[PATH_MAX];
@@ -148,6 +149,9 @@ static void hls_open_files(struct hls_info *info, const char *input)
     strcpy(dir + len_dir, name);
     info->host_h = fopen(dir, "w");
     print_xilinx_host_header(info->host_h);
+    if (options->autosa->fast_drain_merge)
+      /* memcpy and threads are used to merge the drained data. */
+      fprintf(info->host_h, "#include <cstring>\n#include <thread>\n\n");
     fprintf(info->host_c, "#include \"%s\"\n", name);
   }
 
@@ -200,6 +204,12 @@ static void hls_open_files(struct hls_info *info, const char *input)
     
   fprintf(info->kernel_h, "#include <ap_int.h>\n");
   fprintf(info->kernel_h, "#include <hls_stream.h>\n");
+  if (options->autosa->simd_reduce_tree_stage > 0)
+    /* hls::reg is used to register the adder tree stages. */
+    fprintf(info->kernel_h, "#include <ap_utils.h>\n");
+  if (info->hls && options->autosa->fast_drain_merge)
+    /* memcpy is used to merge the drained data. */
+    fprintf(info->kernel_h, "#include <cstring>\n");
   fprintf(info->kernel_h, "\n");  
 
   fprintf(info->kernel_h, "#define min(x,y) ((x < y) ? x : y)\n");
@@ -1435,13 +1445,23 @@ static __isl_give isl_printer *clear_device_xilinx(__isl_take isl_printer *p,
   return p;
 }
 
+/* Print the code that merges the drained data of the ports of "func" 
+ * on the host.
+ * With --fast-drain-merge, the OpenCL host merges each port in its own 
+ * thread, since different ports drain disjoint array elements.
+ * The HLS host used in C simulation merges the ports one by one.
+ */
 static __isl_give isl_printer *drain_merge_xilinx(
     __isl_take isl_printer *p, struct autosa_prog *prog,
     struct autosa_drain_merge_func *func,
     int hls)
 {
   struct autosa_array_ref_group *group = func->group;
+  int threaded = func->kernel->options->autosa->fast_drain_merge && !hls;
+
   p = print_str_new_line(p, "// Merge results");
+  if (threaded)
+    p = print_str_new_line(p, "std::vector<std::thread> merge_threads;");
   p = isl_printer_start_line(p);
   p = isl_printer_print_str(p, "for (int idx = ");
   p = isl_printer_print_int(p, group->mem_port_id);
@@ -1451,15 +1471,27 @@ static __isl_give isl_printer *drain_merge_xilinx(
   p = isl_printer_end_line(p);
 
   p = isl_printer_indent(p, 2);
+  if (threaded) {
+    p = print_str_new_line(p, "merge_threads.emplace_back([&, idx]() {");
+    p = isl_printer_indent(p, 2);
+  }
   p = isl_printer_start_line(p);
   p = autosa_array_ref_group_print_prefix(group, p);
   p = isl_printer_print_str(p, "_drain_merge(");
   p = print_drain_merge_arguments(p, func->kernel, group, func, 0, hls);
   p = isl_printer_print_str(p, ");");
   p = isl_printer_end_line(p);
+  if (threaded) {
+    p = isl_printer_indent(p, -2);
+    p = print_str_new_line(p, "});");
+  }
 
   p = isl_printer_indent(p, -2);
   p = print_str_new_line(p, "}");
+  if (threaded) {
+    p = print_str_new_line(p, "for (auto &t : merge_threads)");
+    p = print_str_new_line(p, "  t.join();");
+  }
   p = isl_printer_end_line(p);
   return p;
 }
@@ -2106,6 +2138,20 @@ static __isl_give isl_printer *print_module_var_xilinx(
       p = isl_printer_print_str(p, "_ping");
     p = isl_printer_print_str(p, " dim=0 complete");
     p = isl_printer_end_line(p);
+    if (var->acc_reg) {
+      /* The same accumulator register is updated again after "acc_dist" 
+       * iterations of the latency hiding loops. The dependence is kept with 
+       * its distance so that HLS does not schedule the next update before 
+       * the previous one finishes. */
+      p = isl_printer_start_line(p);
+      p = isl_printer_print_str(p, "#pragma HLS DEPENDENCE variable=");
+      p = isl_printer_print_str(p, var->name);
+      if (double_buffer)
+        p = isl_printer_print_str(p, "_ping");
+      p = isl_printer_print_str(p, " inter true distance=");
+      p = isl_printer_print_int(p, var->acc_dist);
+      p = isl_printer_end_line(p);
+    }
   }
 
   if (use_memory)
@@ -2355,6 +2401,166 @@ static __isl_give isl_printer *print_for_with_unroll(
   return p;
 }
 
+/* Print the SIMD reduction loop described by "info".
+ *
+ * If per-lane partial sums are kept for the accumulator inside the PE,
+ * the loop updates the lane buffer directly and the lanes are reduced
+ * when the data is drained out.
+ * Otherwise, the loop is printed as
+ *
+ * {
+ *   [type] acc_lane[n_lane];
+ *   for (int c = 0; c < n_lane; c++)
+ *     acc_lane[c] = 0;
+ *   for (int c = 0; c <= n_lane - 1; c += 1)
+ *     acc_lane[c] += f(c);
+ *   [type] acc_lane_sum_1_0 = acc_lane[0] + acc_lane[1];
+ *   ...
+ *   acc = acc + acc_lane_sum_n_0;
+ * }
+ *
+ * so that the lanes are reduced by a balanced adder tree instead of 
+ * a linear chain.
+ */
+static __isl_give isl_printer *print_for_simd_reduce(
+    __isl_keep isl_ast_node *node, __isl_take isl_printer *p,
+    __isl_take isl_ast_print_options *print_options,
+    struct autosa_simd_reduce_info *info, int lane_partial, int stage)
+{
+  struct autosa_kernel_stmt *stmt = info->stmt;
+  isl_ctx *ctx = isl_printer_get_ctx(p);
+  isl_id_to_ast_expr *ref2expr;
+  isl_ast_expr *lane;
+  const char *iterator = isl_id_get_name(info->iterator);
+
+  lane = autosa_simd_reduce_lane_expr(info->acc,
+            isl_ast_expr_from_id(isl_id_copy(info->iterator)), lane_partial);
+  ref2expr = stmt->u.d.ref2expr;
+  stmt->u.d.ref2expr = autosa_simd_reduce_remap(ref2expr, info->acc, lane);
+  isl_ast_expr_free(lane);
+
+  if (lane_partial)
+  {
+    p = isl_ast_node_for_print(node, p, print_options);
+  }
+  else
+  {
+    std::vector<std::string> lanes;
+    std::string root;
+    char *acc_name = autosa_simd_reduce_acc_name(info->acc);
+    char *lane_name = concat(ctx, acc_name, "lane");
+
+    p = ppcg_start_block(p);
+    /* [type] acc_lane[n_lane]; */
+    p = isl_printer_start_line(p);
+    p = isl_printer_print_str(p, info->type);
+    p = isl_printer_print_str(p, " ");
+    p = isl_printer_print_str(p, lane_name);
+    p = isl_printer_print_str(p, "[");
+    p = isl_printer_print_int(p, info->n_lane);
+    p = isl_printer_print_str(p, "];");
+    p = isl_printer_end_line(p);
+    p = isl_printer_start_line(p);
+    p = isl_printer_print_str(p, "#pragma HLS ARRAY_PARTITION variable=");
+    p = isl_printer_print_str(p, lane_name);
+    p = isl_printer_print_str(p, " complete");
+    p = isl_printer_end_line(p);
+
+    /* Initialize the lanes. */
+    p = isl_printer_start_line(p);
+    p = isl_printer_print_str(p, "for (");
+    p = isl_printer_print_str(p, isl_options_get_ast_iterator_type(ctx));
+    p = isl_printer_print_str(p, " ");
+    p = isl_printer_print_str(p, iterator);
+    p = isl_printer_print_str(p, " = 0; ");
+    p = isl_printer_print_str(p, iterator);
+    p = isl_printer_print_str(p, " < ");
+    p = isl_printer_print_int(p, info->n_lane);
+    p = isl_printer_print_str(p, "; ");
+    p = isl_printer_print_str(p, iterator);
+    p = isl_printer_print_str(p, "++) {");
+    p = isl_printer_end_line(p);
+    p = isl_printer_indent(p, 2);
+    p = print_str_new_line(p, "#pragma HLS UNROLL");
+    p = isl_printer_start_line(p);
+    p = isl_printer_print_str(p, lane_name);
+    p = isl_printer_print_str(p, "[");
+    p = isl_printer_print_str(p, iterator);
+    p = isl_printer_print_str(p, "] = 0;");
+    p = isl_printer_end_line(p);
+    p = isl_printer_indent(p, -2);
+    p = print_str_new_line(p, "}");
+
+    p = isl_ast_node_for_print(node, p, print_options);
+
+    /* Reduce the lanes. */
+    for (int l = 0; l < info->n_lane; l++)
+      lanes.push_back(std::string(lane_name) + "[" + std::to_string(l) + "]");
+    p = autosa_print_reduce_tree(p, info->type, lane_name, lanes, stage, root);
+    p = isl_printer_start_line(p);
+    p = isl_printer_print_ast_expr(p, info->acc);
+    p = isl_printer_print_str(p, " = ");
+    p = isl_printer_print_ast_expr(p, info->acc);
+    p = isl_printer_print_str(p, " + ");
+    p = isl_printer_print_str(p, root.c_str());
+    p = isl_printer_print_str(p, ";");
+    p = isl_printer_end_line(p);
+    p = ppcg_end_block(p);
+
+    free(acc_name);
+    free(lane_name);
+  }
+
+  isl_id_to_ast_expr_free(stmt->u.d.ref2expr);
+  stmt->u.d.ref2expr = ref2expr;
+
+  return p;
+}
+
+/* Check if the for node "node" is a SIMD reduction loop that should be
+ * printed with print_for_simd_reduce.
+ * "lane_partial" is set if the accumulator keeps per-lane partial sums
+ * inside the PE.
+ */
+static isl_bool is_simd_reduce_for(__isl_keep isl_ast_node *node,
+                                   struct print_hw_module_data *hw_data,
+                                   struct autosa_simd_reduce_info *info,
+                                   int *lane_partial)
+{
+  struct autosa_hw_module *module = hw_data->module;
+  struct autosa_options *options;
+  char *acc_name;
+
+  *lane_partial = 0;
+  if (!module)
+    return isl_bool_false;
+  options = module->options->autosa;
+  if (!options->simd_reduce_tree && !options->simd_lane_partial_sum)
+    return isl_bool_false;
+  if (module->type != PE_MODULE)
+    return isl_bool_false;
+  if (autosa_simd_reduce_extract(node, hw_data->prog, info) != isl_bool_true)
+    return isl_bool_false;
+
+  acc_name = autosa_simd_reduce_acc_name(info->acc);
+  for (int i = 0; i < module->n_var; i++)
+  {
+    struct autosa_kernel_var *var = &module->var[i];
+    if (acc_name && !strcmp(var->name, acc_name) &&
+        var->array->local_array->n_lane_partial == info->n_lane)
+      *lane_partial = 1;
+  }
+  free(acc_name);
+
+  if (!*lane_partial && !options->simd_reduce_tree)
+  {
+    autosa_simd_reduce_info_clear(info);
+    return isl_bool_false;
+  }
+
+  return isl_bool_true;
+}
+
 static __isl_give isl_printer *print_for_xilinx(__isl_take isl_printer *p,
                                                 __isl_take isl_ast_print_options *print_options,
                                                 __isl_keep isl_ast_node *node, void *user)
@@ -2362,6 +2568,17 @@ static __isl_give isl_printer *print_for_xilinx(__isl_take isl_printer *p,
   isl_id *id;
   int pipeline;
   int unroll;
+  int lane_partial;
+  struct autosa_simd_reduce_info reduce_info;
+  struct print_hw_module_data *hw_data = (struct print_hw_module_data *)user;
+
+  if (is_simd_reduce_for(node, hw_data, &reduce_info, &lane_partial))
+  {
+    p = print_for_simd_reduce(node, p, print_options, &reduce_info,
+          lane_partial, hw_data->module->options->autosa->simd_reduce_tree_stage);
+    autosa_simd_reduce_info_clear(&reduce_info);
+    return p;
+  }
 
   pipeline = 0;
   unroll = 0;
@@ -3033,6 +3250,158 @@ static __isl_give isl_printer *autosa_print_serialize_module(
   return p;
 }
 
+struct simd_lane_partial_data
+{
+  struct autosa_hw_module *module;
+  struct autosa_prog *prog;
+  /* Number of SIMD lanes of each module variable. 
+   * -1 if the per-lane partial sums can't be applied.
+   */
+  std::vector<int> n_lane;
+};
+
+/* Collect the SIMD reduction loops that accumulate into the module variables.
+ * A variable can only keep per-lane partial sums if it is not read by 
+ * any other user statement in the PE and all the reduction loops on it 
+ * share the same number of lanes.
+ */
+static isl_bool extract_simd_lane_partial(__isl_keep isl_ast_node *node,
+                                          void *user)
+{
+  struct simd_lane_partial_data *data = (struct simd_lane_partial_data *)user;
+  struct autosa_hw_module *module = data->module;
+
+  if (isl_ast_node_get_type(node) == isl_ast_node_for)
+  {
+    struct autosa_simd_reduce_info info;
+    char *acc_name;
+
+    if (autosa_simd_reduce_extract(node, data->prog, &info) != isl_bool_true)
+      return isl_bool_true;
+    acc_name = autosa_simd_reduce_acc_name(info.acc);
+    for (int i = 0; i < module->n_var; i++)
+    {
+      if (!acc_name || strcmp(module->var[i].name, acc_name))
+        continue;
+      if (data->n_lane[i] == 0)
+        data->n_lane[i] = info.n_lane;
+      else if (data->n_lane[i] != info.n_lane)
+        data->n_lane[i] = -1;
+    }
+    free(acc_name);
+    autosa_simd_reduce_info_clear(&info);
+    /* Skip the reduction statement. */
+    return isl_bool_false;
+  }
+
+  if (isl_ast_node_get_type(node) == isl_ast_node_user)
+  {
+    isl_id *id = isl_ast_node_get_annotation(node);
+    struct autosa_kernel_stmt *stmt;
+
+    if (!id)
+      return isl_bool_true;
+    stmt = (struct autosa_kernel_stmt *)isl_id_get_user(id);
+    isl_id_free(id);
+    if (!stmt || stmt->type != AUTOSA_KERNEL_STMT_DOMAIN)
+      return isl_bool_true;
+    for (struct autosa_stmt_access *access = stmt->u.d.stmt->accesses;
+         access; access = access->next)
+    {
+      const char *name;
+      if (!access->read)
+        continue;
+      name = isl_map_get_tuple_name(access->access, isl_dim_out);
+      for (int i = 0; i < module->n_var; i++)
+      {
+        if (name && !strcmp(module->var[i].array->name, name))
+          data->n_lane[i] = -1;
+      }
+    }
+  }
+
+  return isl_bool_true;
+}
+
+/* Keep per-lane partial sums for the PE local buffers that are only 
+ * updated by SIMD reductions and drained out afterwards.
+ * The number of lanes is stored in "n_lane_partial" of the local array
+ * so that the drain statements can reduce the lanes.
+ * Print the declaration and initialization of the lane buffers.
+ *
+ * [type] local_lane[...][n_lane];
+ */
+static __isl_give isl_printer *print_simd_lane_partial_vars_xilinx(
+  __isl_take isl_printer *p, struct autosa_hw_module *module,
+  struct autosa_prog *prog, __isl_keep isl_ast_node *tree,
+  struct hls_info *hls)
+{
+  struct simd_lane_partial_data data;
+  isl_ctx *ctx = isl_printer_get_ctx(p);
+
+  if (module->type != PE_MODULE || 
+      !module->options->autosa->simd_lane_partial_sum)
+    return p;
+
+  data.module = module;
+  data.prog = prog;
+  data.n_lane = std::vector<int>(module->n_var, 0);
+  if (isl_ast_node_foreach_descendant_top_down(tree, 
+        &extract_simd_lane_partial, &data) < 0)
+    return isl_printer_free(p);
+
+  for (int i = 0; i < module->n_var; i++)
+  {
+    struct autosa_kernel_var *var = &module->var[i];
+    struct autosa_local_array_info *local_array = var->array->local_array;
+    struct autosa_kernel_var lane_var;
+    int n_dim = isl_vec_size(var->size);
+    char *lane_name;
+
+    local_array->n_lane_partial = 0;
+    if (data.n_lane[i] <= 1 || !local_array->drain_group)
+      continue;
+    local_array->n_lane_partial = data.n_lane[i];
+
+    lane_name = concat(ctx, var->name, "lane");
+    lane_var.array = var->array;
+    lane_var.name = lane_name;
+    lane_var.size = isl_vec_alloc(ctx, n_dim + 1);
+    for (int j = 0; j < n_dim; j++)
+      lane_var.size = isl_vec_set_element_val(lane_var.size, j,
+                        isl_vec_get_element_val(var->size, j));
+    lane_var.size = isl_vec_set_element_si(lane_var.size, n_dim, data.n_lane[i]);
+
+    p = isl_printer_start_line(p);
+    p = isl_printer_print_str(p, var->array->type);
+    p = isl_printer_print_str(p, " ");
+    p = isl_printer_print_str(p, lane_name);
+    for (int j = 0; j <= n_dim; j++)
+    {
+      isl_val *v = isl_vec_get_element_val(lane_var.size, j);
+      p = isl_printer_print_str(p, "[");
+      p = isl_printer_print_val(p, v);
+      p = isl_printer_print_str(p, "]");
+      isl_val_free(v);
+    }
+    p = isl_printer_print_str(p, ";");
+    p = isl_printer_end_line(p);
+    p = isl_printer_start_line(p);
+    p = isl_printer_print_str(p, "#pragma HLS ARRAY_PARTITION variable=");
+    p = isl_printer_print_str(p, lane_name);
+    p = isl_printer_print_str(p, " dim=");
+    p = isl_printer_print_int(p, n_dim + 1);
+    p = isl_printer_print_str(p, " complete");
+    p = isl_printer_end_line(p);
+    p = autosa_print_var_initialization(p, &lane_var, hls->target);
+
+    isl_vec_free(lane_var.size);
+    free(lane_name);
+  }
+
+  return p;
+}
+
 /* Print the default module. 
  * For PE modules, we will print a wrapper function to speedup the HLS 
  * synthesis. 
@@ -3097,6 +3466,8 @@ static __isl_give isl_printer *autosa_print_default_module(
     }
   }
   p = print_module_vars_xilinx(p, module, -1);  
+  p = print_simd_lane_partial_vars_xilinx(p, module, prog, 
+        boundary ? module->boundary_tree : module->device_tree, hls);
   p = print_str_new_line(p, "/* Variable Declaration */");
   p = isl_printer_end_line(p);
 
@@ -3881,6 +4252,7 @@ static __isl_give isl_printer *print_double_buffer_module_while(
   }
 
   struct print_db_module_while_data print_data;
+  int non_block = module->options->autosa->non_block_fifo;
 
   /* Extract the code snippets. */
   extract_double_buffer_module_while_data(module, boundary, &print_data);
@@ -3908,9 +4280,16 @@ static __isl_give isl_printer *print_double_buffer_module_while(
   /* Print inter_trans */
   p = print_str_new_line(p, "if (inter_trans_en) {");
   p = isl_printer_indent(p, 2);
+  if (non_block)
+    p = print_str_new_line(p, "bool inter_stall = 0;");
   /* Print the module logic */
   p = autosa_print_inter_trans_module_double_buffer(p, module, prog, hls, boundary);
   /* Print the loop counter */  
+  if (non_block) {
+    /* Only advance the loop counter if the transfer is not stalled. */
+    p = print_str_new_line(p, "if (!inter_stall) {");
+    p = isl_printer_indent(p, 2);
+  }
   for (int i = 0; i < print_data.inter_for_logic.size(); i++) {    
     p = isl_printer_start_line(p);
     p = isl_printer_print_str(p, print_data.inter_for_logic[i]);
@@ -3923,6 +4302,10 @@ static __isl_give isl_printer *print_double_buffer_module_while(
     p = isl_printer_indent(p, -2);
     p = print_str_new_line(p, "}");
   }
+  if (non_block) {
+    p = isl_printer_indent(p, -2);
+    p = print_str_new_line(p, "}");
+  }
   
   p = isl_printer_indent(p, -2);
   p = print_str_new_line(p, "}");
@@ -3930,9 +4313,16 @@ static __isl_give isl_printer *print_double_buffer_module_while(
   /* Print intra_trans */
   p = print_str_new_line(p, "if (intra_trans_en) {");
   p = isl_printer_indent(p, 2);
+  if (non_block)
+    p = print_str_new_line(p, "bool intra_stall = 0;");
   /* Print the module logic */
   p = autosa_print_intra_trans_module_double_buffer(p, module, prog, hls, boundary);
   /* Print the loop counter */
+  if (non_block) {
+    /* Only advance the loop counter if the transfer is not stalled. */
+    p = print_str_new_line(p, "if (!intra_stall) {");
+    p = isl_printer_indent(p, 2);
+  }
   for (int i = 0; i < print_data.intra_for_logic.size(); i++) {
     p = isl_printer_start_line(p);
     p = isl_printer_print_str(p, print_data.intra_for_logic[i]);
@@ -3945,6 +4335,10 @@ static __isl_give isl_printer *print_double_buffer_module_while(
     p = isl_printer_indent(p, -2);
     p = print_str_new_line(p, "}");
   }
+  if (non_block) {
+    p = isl_printer_indent(p, -2);
+    p = print_str_new_line(p, "}");
+  }
 
   p = isl_printer_indent(p, -2);
   p = print_str_new_line(p, "}");
@@ -4013,6 +4407,7 @@ static __isl_give isl_printer *autosa_print_host_code(__isl_take isl_printer *p,
   /* Print the macros for sparse data structure */
   if (prog->scop->options->autosa->block_sparse) {
     print_sparse_macros(top->kernel, hls);
+    print_sparse_pack_funcs(top->kernel, hls);
   }
 
   /* Print the helper functions in the program. */
@@ -4765,7 +5160,7 @@ int generate_autosa_xilinx_hls_c(isl_ctx *ctx, struct ppcg_options *options,
   hls.ctx = ctx;
   hls.output_dir = options->autosa->output_dir;
   hls.hcl = options->autosa->hcl;
-  hls_open_files(&hls, input);
+  hls_open_files(&hls, input, options);
 
   r = generate_sa(ctx, input, hls.host_c, options, &print_hw, &hls);
 
@@ -814,14 +814,23 @@ static __isl_give isl_mat *get_acc_mat_from_tagged_acc(__isl_keep isl_map *map)
  * We favor non-zero components at the upper level, since they are more likely
  * to be carried by the space loops.
  *
+ * Reuse vectors with multiple non-zero components (e.g., [1,1] for A[i-j]
+ * or the mixed-sign [1,-1] for A[i+j]) are opt-in candidates, which lead 
+ * to diagonal data links between PEs if all the non-zero components are 
+ * mapped to space loops. They are never picked by default. If there is no 
+ * candidate with a single non-zero component, no default is returned, and the 
+ * caller falls back to the pseudo dependence as before.
+ * The single-component candidates are enumerated first so that the candidate 
+ * ids used by "--select-rar-dep" are stable. The multi-component candidates 
+ * are enumerated afterwards and are only picked if selected by users.
+ * Multi-component candidates without a unit component are rejected, since 
+ * the I/O transformation built from them would not be unimodular.
+ *
  * For T2S only:
  * At the second phase of tiled T2S code generation,
  * the coefficients  at space loop dimensions should be no less than zero.
  * For now, we will set any dependence vector with negative coefficient with a negative
  * score -1.
- * 
- * Temporary: We only allow one non-zero component in the reuse vector to simplify
- * the generation of hardware. We may relax it in the future.
  */
 static int rar_sol_smart_pick(
   __isl_keep isl_mat *mat, struct ppcg_scop *ps, int *n_candidates, int *n_default, int user_choice)
@@ -830,34 +839,25 @@ static int rar_sol_smart_pick(
   int depth = isl_mat_rows(mat);
   int pick_idx = -1;
   int min_score = 0;  
-  int min_non_zero_cnt = -1;
   int non_zero_cnts[isl_mat_cols(mat)];
 
+  int has_unit[isl_mat_cols(mat)];
+
   for (int c = 0; c < isl_mat_cols(mat); c++) {
     int non_zero_cnt = 0;
+    has_unit[c] = 0;
     for (int r = 0; r < isl_mat_rows(mat); r++) {
       isl_val *val = isl_mat_get_element_val(mat, r, c);
       long val_int = isl_val_get_num_si(val);
       isl_val_free(val);
       if (val_int != 0)
         non_zero_cnt++;
+      if (val_int == 1 || val_int == -1)
+        has_unit[c] = 1;
     }
     non_zero_cnts[c] = non_zero_cnt;
-    if (min_non_zero_cnt == -1) {
-      min_non_zero_cnt = non_zero_cnt;    
-    } else {
-      if (non_zero_cnt < min_non_zero_cnt)
-        min_non_zero_cnt = non_zero_cnt;
-    }
   }
 
-  /* Temporary: We only allow one non-zero component in the reuse vector to simplify
-   * the generation of hardware. We may relax it in the future.
-   */
-  if (min_non_zero_cnt > 1) {
-	return pick_idx;
-  }
-  
   for (int c = 0; c < isl_mat_cols(mat); c++) {
     score[c] = 0; 
     for (int r = 0; r < isl_mat_rows(mat); r++) {
@@ -873,7 +873,17 @@ static int rar_sol_smart_pick(
         }
       }
     }
-    if (score[c] >= 0 && non_zero_cnts[c] == min_non_zero_cnt) {
+  }
+
+  /* The first pass visits the single-component candidates, the second pass 
+   * visits the multi-component ones.
+   */
+  for (int pass = 0; pass < 2; pass++) {
+    for (int c = 0; c < isl_mat_cols(mat); c++) {
+      if ((non_zero_cnts[c] == 1) != (pass == 0))
+        continue;
+      if (score[c] < 0 || (non_zero_cnts[c] > 1 && !has_unit[c]))
+        continue;
 	  if (user_choice == -1) {
 	    printf("[AutoSA] Candidate %d: ", *n_candidates);
 	    isl_printer *p_tmp = isl_printer_to_file(isl_mat_get_ctx(mat), stdout);
@@ -885,12 +895,8 @@ static int rar_sol_smart_pick(
 	    isl_printer_free(p_tmp);
 	    isl_vec_free(sol_tmp);
 	    printf("\n");
-		if (pick_idx == -1) {
-          pick_idx = c;
-          min_score = score[c];
-		  *n_default = *n_candidates;
-        } else {
-          if (min_score > score[c]) {
+		if (pass == 0) {
+		  if (pick_idx == -1 || min_score > score[c]) {
             pick_idx = c;
             min_score = score[c];
 		    *n_default = *n_candidates;
@@ -898,8 +904,7 @@ static int rar_sol_smart_pick(
         }
 	  }	else {
 	    if (user_choice == *n_candidates) {
-		  pick_idx = c;
-	      break;
+		  return c;
 		}
 	  }
 	  (*n_candidates)++;
@@ -909,6 +914,41 @@ static int rar_sol_smart_pick(
   return pick_idx;
 }
 
+/* Normalize the reuse vectors with multiple non-zero components in the 
+ * null space "mat" to be lexicographically positive, i.e., the first 
+ * non-zero component is positive. 
+ * The direction of the reuse vector with a single non-zero component
+ * is left untouched.
+ */
+static __isl_give isl_mat *normalize_rar_sols(__isl_take isl_mat *mat)
+{
+  if (!mat)
+    return NULL;
+
+  for (int c = 0; c < isl_mat_cols(mat); c++) {
+    int non_zero_cnt = 0;
+    int first_sign = 0;
+    for (int r = 0; r < isl_mat_rows(mat); r++) {
+      isl_val *val = isl_mat_get_element_val(mat, r, c);
+      int sign = isl_val_sgn(val);
+      isl_val_free(val);
+      if (sign != 0) {
+        if (non_zero_cnt == 0)
+          first_sign = sign;
+        non_zero_cnt++;
+      }
+    }
+    if (non_zero_cnt > 1 && first_sign < 0) {
+      for (int r = 0; r < isl_mat_rows(mat); r++) {
+        isl_val *val = isl_mat_get_element_val(mat, r, c);
+        mat = isl_mat_set_element_val(mat, r, c, isl_val_neg(val));
+      }
+    }
+  }
+
+  return mat;
+}
+
 /* Construct a pseudo RAR dependence that is an identity map of the read access. */
 static __isl_give isl_map *construct_pseudo_dep_rar(__isl_keep isl_map *map)
 {
@@ -1045,6 +1085,37 @@ static int read_select_rar_dep_choices(struct ppcg_scop *ps, __isl_keep isl_map
   return ret;	
 }
 
+/* Record the number of legal RAR dep candidates "n_candidates" and the 
+ * default candidate "default_candidate" of the array reference in "map" 
+ * in ps->rar_dep_choices, in the form of 
+ * { kernel[] -> ref_name[n_candidates, default_candidate] }.
+ * The choices are exposed to the auto-tuner in the space-time stage.
+ */
+static void record_rar_dep_choices(struct ppcg_scop *ps, __isl_keep isl_map *map,
+  int n_candidates, int default_candidate)
+{
+  isl_set *domain = isl_map_domain(isl_map_copy(map));
+  isl_map *domain_map = isl_set_unwrap(domain);
+  isl_space *space = isl_map_get_space(domain_map);
+  isl_map_free(domain_map);
+  const char *ref_name = isl_space_get_tuple_name(space, isl_dim_out);
+  isl_printer *p_str = isl_printer_to_str(isl_map_get_ctx(map));
+  p_str = isl_printer_print_str(p_str, "{ kernel[] -> ");
+  p_str = isl_printer_print_str(p_str, ref_name);
+  p_str = isl_printer_print_str(p_str, "[");
+  p_str = isl_printer_print_int(p_str, n_candidates);
+  p_str = isl_printer_print_str(p_str, ", ");
+  p_str = isl_printer_print_int(p_str, default_candidate);
+  p_str = isl_printer_print_str(p_str, "] }");
+  char *choice_str = isl_printer_get_str(p_str);
+  isl_printer_free(p_str);
+  isl_space_free(space);
+
+  ps->rar_dep_choices = isl_union_map_union(ps->rar_dep_choices, 
+      isl_union_map_read_from_str(isl_map_get_ctx(map), choice_str));
+  free(choice_str);
+}
+
 /* Builds the RAR dependence for the given access "map".
  * First we examine the access is an external access (not assoiciated with
  * any flow dependence). Next, we compute the null space of the access matrix.
@@ -1065,6 +1136,7 @@ static isl_stat build_rar_dep(__isl_take isl_map *map, void *user) {
   /* Take the access function and compute the null space */
   isl_mat *acc_mat = get_acc_mat_from_tagged_acc(map); 
   isl_mat *acc_null_mat = isl_mat_right_kernel(acc_mat);
+  acc_null_mat = normalize_rar_sols(acc_null_mat);
   int nsol = isl_mat_cols(acc_null_mat);  
   if (nsol > 0) {
   	/* Build the RAR dependence.
@@ -1084,20 +1156,25 @@ static isl_stat build_rar_dep(__isl_take isl_map *map, void *user) {
 	}
 	int default_candidate = -1;
     int col = rar_sol_smart_pick(acc_null_mat, ps, &n_candidates, &default_candidate, -1);
-	if (col >= 0) {
-	  /* Check if users have specified any choice. */
+	if (n_candidates > 1 || (n_candidates == 1 && col < 0)) {
+	  /* Check if users have specified any choice. 
+	   * The multi-component candidates are only used when selected. 
+	   */
 	  int user_choice = read_select_rar_dep_choices(ps, map);
-      if (n_candidates > 1) {
-		printf("[AutoSA] Found more than one legal RAR deps. ");
-		if (user_choice == -1)
+	  printf("[AutoSA] Found %d legal RAR deps. ", n_candidates);
+	  if (user_choice == -1) {
+		if (col >= 0)
 		  printf("Candidate %d is used by default.\n", default_candidate);
-		else {
-		  printf("Candidate %d is used.\n", user_choice);
-		  n_candidates = 0;
-		  col = rar_sol_smart_pick(acc_null_mat, ps, &n_candidates, &default_candidate, user_choice);
-		}
+		else
+		  printf("None of them is used by default.\n");
+		record_rar_dep_choices(ps, map, n_candidates, default_candidate);
+	  } else {
+		printf("Candidate %d is used.\n", user_choice);
+		n_candidates = 0;
+		col = rar_sol_smart_pick(acc_null_mat, ps, &n_candidates, &default_candidate, user_choice);
 	  }
-
+	}
+	if (col >= 0) {
       isl_vec *sol = isl_vec_alloc(isl_map_get_ctx(map), isl_mat_rows(acc_null_mat));
       for (int row = 0; row < isl_mat_rows(acc_null_mat); row++) {
         sol = isl_vec_set_element_val(sol, row, isl_mat_get_element_val(acc_null_mat, row, col));
@@ -1168,6 +1245,7 @@ static void compute_tagged_rar_dep(struct ppcg_scop *ps)
   ps->tagged_dep_rar = isl_union_map_empty(
 			isl_space_set_alloc(isl_union_map_get_ctx(ps->tagged_dep_flow),
         isl_space_dim(space, isl_dim_param), 0));
+  ps->rar_dep_choices = isl_union_map_empty(isl_union_map_get_space(ps->tagged_dep_rar));
   isl_space_free(space);
   compute_tagged_rar_dep_only(ps);
   derive_rar_dep_from_tagged_rar_dep(ps);
@@ -1394,6 +1472,7 @@ static void *ppcg_scop_free(struct ppcg_scop *ps)
 	/* AutoSA Extended */
 	isl_union_map_free(ps->tagged_dep_rar);
 	isl_union_map_free(ps->dep_rar);
+	isl_union_map_free(ps->rar_dep_choices);
 	isl_union_map_free(ps->tagged_dep_waw);
 	isl_union_map_free(ps->dep_waw);
 	/* AutoSA Extended */
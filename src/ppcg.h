@@ -261,6 +261,8 @@ extern "C"
 		/* AutoSA Extended */
 		isl_union_map *dep_rar;
 		isl_union_map *tagged_dep_rar;
+		/* Number of legal and default RAR dep candidates of each reference. */
+		isl_union_map *rar_dep_choices;
 		isl_union_map *dep_waw;
 		isl_union_map *tagged_dep_waw;
 		/* AutoSA Extended */
@@ -27,6 +27,12 @@ static struct isl_arg_choice sa_type[] = {
 	{"async", AUTOSA_SA_TYPE_ASYNC},
 	{0}};
 
+static struct isl_arg_choice block_sparse_format[] = {
+	{"dense", AUTOSA_SPARSE_FORMAT_DENSE},
+	{"csr", AUTOSA_SPARSE_FORMAT_CSR},
+	{"csc", AUTOSA_SPARSE_FORMAT_CSC},
+	{0}};
+
 /* Set defaults that depend on the target.
  * In particular, set --schedule-outer-coincidence iff target is a GPU.
  */
@@ -88,12 +94,21 @@ ISL_ARGS_END
 ISL_ARGS_START(struct autosa_options, autosa_options_args)
 ISL_ARG_BOOL(struct autosa_options, autosa, 0, "autosa", 1,
 				"generate systolic arrays using AutoSA")
+ISL_ARG_INT(struct autosa_options, acc_latency, 0, "acc-latency", "cycles", 0,
+				"latency of the accumulation in PEs, promote the accumulators to registers if set")
+ISL_ARG_INT(struct autosa_options, acc_reg_max, 0, "acc-reg-max", "n", 64,
+				"maximal number of elements of the accumulators promoted to registers")
 ISL_ARG_BOOL(struct autosa_options, array_contraction, 0, "array-contraction", 1,
 				"apply array contraction")
+ISL_ARG_BOOL(struct autosa_options, auto_buffer_assign, 0, "auto-buffer-assign", 0,
+				"decide the double buffering and two-level buffering of each I/O group by the estimated latency and BRAM cost")
 ISL_ARG_BOOL(struct autosa_options, axi_stream, 0, "axi-stream", 0,
 				"generate AXI stream interface, must be used together with host serialization.")
 ISL_ARG_BOOL(struct autosa_options, block_sparse, 0, "block-sparse", 0,
 				"use block sparsity")
+ISL_ARG_USER_OPT_CHOICE(struct autosa_options, block_sparse_format, 0, "block-sparse-format", 
+				block_sparse_format, NULL, AUTOSA_SPARSE_FORMAT_DENSE, AUTOSA_SPARSE_FORMAT_DENSE, 
+				"host-side format of the sparse array, generate the helper functions to pack it into the block sparse stream")
 ISL_ARG_STR(struct autosa_options, block_sparse_ratio, 0, "block-sparse-ratio", "ratio",
 				NULL, "block sparsity ratio (e.g., kernel[]->A[2,4])")
 ISL_ARG_STR(struct autosa_options, config, 0, "config", "config", NULL,
@@ -114,8 +129,10 @@ ISL_ARG_BOOL(struct autosa_options, dump_code, 0, "dump-code", 0,
 			 	"dump the intermediate code")
 ISL_ARG_BOOL(struct autosa_options, explore_loop_permute, 0, "explore-loop-permute", 0,
 				"explore loop permutation in the step of array partitioning")
-ISL_ARG_INT(struct autosa_options, loop_permute_order, 0, "loop-permute-order", "order", 0,
-				"specify which loop ordering to be explored")
+ISL_ARG_INT(struct autosa_options, loop_permute_order, 0, "loop-permute-order", "order", -1,
+				"specify which loop ordering to be explored (-1: all orderings in the tuning mode)")
+ISL_ARG_BOOL(struct autosa_options, fast_drain_merge, 0, "fast-drain-merge", 0,
+				"merge the drained data of the multi-port arrays on the host with memcpy blocks and one thread per port")
 ISL_ARG_INT(struct autosa_options, fifo_depth, 0, "fifo-depth", "depth", 2, "default FIFO depth")
 ISL_ARG_BOOL(struct autosa_options, hbm, 0, "hbm", 0,
 			 	"use multi-port DRAM/HBM")
@@ -125,16 +142,20 @@ ISL_ARG_BOOL(struct autosa_options, hls, 0, "hls", 0,
 			 	"generate Xilinx HLS host")
 ISL_ARG_BOOL(struct autosa_options, host_serialize, 0, "host-serialize", 0,
 			 	"serialize/deserialize the host data")
+ISL_ARG_STR(struct autosa_options, hw_info, 0, "hw-info", "file", NULL,
+				"FPGA resource budget (e.g., autosa_config/hw_info.json), warn about and record the designs that may exceed it")
 ISL_ARG_BOOL(struct autosa_options, insert_hls_dependence, 0, "insert-hls-dependence", 0,
 			 	"insert Xilinx HLS dependence pragma (alpha version)")
 ISL_ARG_INT(struct autosa_options, int_io_dir, 0, "int-io-dir", "dir", 0,
 			 	"set the default interior I/O direction (0: [1,x] 1: [x,1])")
 ISL_ARG_BOOL(struct autosa_options, io_module_embedding, 0, "io-module-embedding", 0,
 			 	"embed the I/O modules inside PEs if possible")
+ISL_ARG_ULONG(struct autosa_options, isl_max_operations, 0, "isl-max-operations", 0,
+				"ISL operation budget of each expensive compilation step, with a fallback applied when exceeded (0: unlimited)")
 ISL_ARG_BOOL(struct autosa_options, isl_sink, 0, "isl-sink", 1,
 			 	"sink time loops using ISL default APIs")
 ISL_ARG_BOOL(struct autosa_options, loop_infinitize, 0, "loop-infinitize", 0,
-			 	"apply loop infinitization optimization (Intel OpenCL only)")
+			 	"apply loop infinitization optimization (Intel OpenCL and TAPA)")
 ISL_ARG_BOOL(struct autosa_options, local_reduce, 0, "local-reduce", 0,
 			 	"generate non-output-stationary array with local reduction")
 ISL_ARG_STR(struct autosa_options, reduce_op, 0, "reduce-op", "op",
@@ -150,9 +171,11 @@ ISL_ARG_INT(struct autosa_options, max_sa_dim, 0,
 ISL_ARG_STR(struct autosa_options, mem_port_map, 0, "mem-port-map", "map", NULL,
 				"memory port mapping")
 ISL_ARG_BOOL(struct autosa_options, non_block_fifo, 0, "non-blocking-fifo", 0,
-			 	"use non-blocking fifo interface")
+			 	"use non-blocking fifo interface in double buffered I/O modules (Xilinx HLS C and TAPA)")
 ISL_ARG_STR(struct autosa_options, output_dir, 0, "output-dir", "dir", "./autosa.tmp/output",
 				"AutoSA Output directory")
+ISL_ARG_BOOL(struct autosa_options, pe_buffer_contraction, 0, "pe-buffer-contraction", 0,
+				"contract the PE buffers of the internal arrays to the data live across the loops carrying their dependences")
 ISL_ARG_BOOL(struct autosa_options, reverse_order, 0, "reverse-order", 1,
 			 	"reverse latency hiding loop tiling order")			
 ISL_ARG_STR(struct autosa_options, select_rar_dep, 0, "select-rar-dep", "choice",
@@ -167,6 +190,12 @@ ISL_ARG_STR(struct autosa_options, simd_info, 0, "simd-info", "info", NULL,
 				"per kernel SIMD information")
 ISL_ARG_BOOL(struct autosa_options, simd_touch_space, 0, "simd-touch-space", 0,
 				"use space loops as SIMD vectorization loops")
+ISL_ARG_BOOL(struct autosa_options, simd_lane_partial_sum, 0, "simd-lane-partial-sum", 0,
+				"keep per-lane partial sums in PEs and reduce them at drain (Xilinx only)")
+ISL_ARG_BOOL(struct autosa_options, simd_reduce_tree, 0, "simd-reduce-tree", 0,
+				"reduce SIMD lanes with a balanced adder tree (Xilinx only)")
+ISL_ARG_INT(struct autosa_options, simd_reduce_tree_stage, 0, "simd-reduce-tree-stage", "stage", 0,
+				"insert a register stage every N levels of the SIMD adder tree")
 ISL_ARG_INT(struct autosa_options, tuning_method, 0, "tuning-method", "method", -1,
 				"tuning method (0: exhaustive search 1: others)")
 ISL_ARG_BOOL(struct autosa_options, two_level_buffer, 0, "two-level-buffer", 0,
@@ -25,6 +25,9 @@ extern "C"
 		/* Use HBM memory. */
 		int hbm;
 		int n_hbm_port;
+		/* Merge the drained data of the multi-port arrays on the host with
+		 * contiguous memcpy blocks and one thread per port. */
+		int fast_drain_merge;
 		/* Enable double buffering. */
 		int double_buffer;
 		/* Double buffer assignment. */
@@ -57,14 +60,23 @@ extern "C"
 		int credit_control;
 		/* Enable two-level buffering in I/O modules. */
 		int two_level_buffer;
+		/* Decide the double buffering and two-level buffering of each I/O 
+		 * group by the estimated latency and BRAM cost. */
+		int auto_buffer_assign;
 		/* Configuration file. */
 		char *config;
 		/* Output directory. */
 		char *output_dir;
+		/* Contract the PE buffers of the internal arrays to the data live 
+		 * across the loops carrying their dependences. */
+		int pe_buffer_contraction;
 		/* SIMD information file. */
 		char *simd_info;
 		/* Generate HLS host instead of OpenCL host. */
 		int hls;
+		/* FPGA resource budget file. Designs that may exceed the budget are
+		 * reported in resource_est/budget_check.json. */
+		char *hw_info;
 		/* Use URAM. */
 		int uram;
 		/* Print verbose information. */
@@ -73,11 +85,15 @@ extern "C"
 		int insert_hls_dependence;
 		/* Embed I/O modules inside PEs. */
 		int io_module_embedding;
-		/* Enable loop infinitization optimization. Only for Intel. */
+		/* Enable loop infinitization optimization. Only for Intel and TAPA. 
+		 * TAPA modules are invoked as detached tasks.
+		 */
 		int loop_infinitize;
 		/* Enable data serialization/deserialization on the host side. */
 		int host_serialize;
-		/* Use non-blocking FIFO access. Note: Not supported. */
+		/* Use non-blocking FIFO access in the double buffered I/O modules. 
+		 * Only supported for Xilinx HLS C and TAPA with the while-loop double 
+		 * buffer style. */
 		int non_block_fifo;
 		/* Double buffer coding style. 0: for loop (default) 1: while loop */
 		int double_buffer_style;
@@ -100,16 +116,36 @@ extern "C"
 		int fifo_depth;
 		/* Touch space loops in the SIMD vectorization */
 		int simd_touch_space;
+		/* Reduce the SIMD lanes with a balanced adder tree. */
+		int simd_reduce_tree;
+		/* Insert a register stage every N levels of the adder tree. 
+		 * 0: no register stage (default).
+		 */
+		int simd_reduce_tree_stage;
+		/* Keep one partial sum per SIMD lane and reduce the lanes at drain. */
+		int simd_lane_partial_sum;
+		/* Latency of the accumulation in PEs (cycles).
+		 * 0: do not promote the accumulators to registers (default).
+		 */
+		int acc_latency;
+		/* Maximal number of elements of the accumulators promoted to 
+		 * registers. */
+		int acc_reg_max;
 		/* Use block sparsity */
 		int block_sparse;
 		/* Block sparse ratio [nonzero, vec_len] */
 		char* block_sparse_ratio;
+		/* Host-side format of the sparse array. 
+		 * The host packs the array into the block sparse stream. */
+		int block_sparse_format;
 		/* Generate code for HeteroCL integration. */
 		int hcl;
 		/* Apply array contraction. */
 		int array_contraction;
 		/* Sinking time loops using ISL default APIs. */
 		int isl_sink;
+		/* ISL operation budget of each expensive compilation step. */
+		unsigned long isl_max_operations;
 		/* Reverse the loop tiling order. */
 		int reverse_order;
 		/* Use AXI Stream Interface. */
@@ -118,6 +154,7 @@ extern "C"
 		int tuning_method;
 		/* Explore loop permutation in the array partitioning. */
 		int explore_loop_permute;
+		/* The loop ordering to be explored. -1 for all the orderings. */
 		int loop_permute_order;
 		/* Parameter names */
 		char *param_names;
@@ -221,6 +258,10 @@ extern "C"
 #define AUTOSA_SA_TYPE_SYNC 0
 #define AUTOSA_SA_TYPE_ASYNC 1
 
+#define AUTOSA_SPARSE_FORMAT_DENSE 0
+#define AUTOSA_SPARSE_FORMAT_CSR 1
+#define AUTOSA_SPARSE_FORMAT_CSC 2
+
 	void ppcg_options_set_target_defaults(struct ppcg_options *options);
 
 #ifdef __cplusplus